@@ -0,0 +1,244 @@
+/*
+ * This is the program that lists the potential Sphincs+ parameter sets,
+ * given the target requirements (security level, number of signatures at
+ * that security level, overuse characteristics)
+ *
+ * This part of the program works out what each of the hash operations
+ * SLH-DSA does actually costs, for a specific hash function.  The search
+ * counts the hash operations; however, what we actually pay for is the
+ * number of SHA-256 (or SHA-512) compression function calls, or Keccak
+ * permutations; and that depends on n, on how long the input is (including
+ * PK.seed and the ADRS structure), and on the padding
+ *
+ * The input layouts are the ones from FIPS 205 (section 11)
+ *
+ * It also times those primitives on this host, so that we can convert those
+ * counts into a predicted time
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "cost.h"
+#include "hash.h"
+
+/*
+ * The number of compression function calls it takes to hash len bytes with
+ * a Merkle-Damgard hash with the given block size; the padding adds a 1 bit
+ * and the length (8 bytes for SHA-256, 16 for SHA-512)
+ */
+static unsigned md_blocks( unsigned len, unsigned block, unsigned length_bytes ) {
+    return (len + 1 + length_bytes + block - 1) / block;
+}
+static unsigned sha256_blocks( unsigned len ) { return md_blocks( len, 64, 8 ); }
+static unsigned sha512_blocks( unsigned len ) { return md_blocks( len, 128, 16 ); }
+
+/*
+ * The number of Keccak-f[1600] permutations it takes for SHAKE256 to absorb
+ * len bytes; the padding always needs at least one byte.  None of the
+ * outputs we want is longer than the rate, so there is no extra squeeze
+ */
+static unsigned shake256_blocks( unsigned len ) {
+    return len / 136 + 1;
+}
+
+#define ADRS_BYTES  32      /* The ADRS structure */
+#define ADRSC_BYTES 22      /* The compressed ADRS the SHA2 versions use */
+
+/*
+ * The SHA2 versions.  For n=16, everything is SHA-256; for larger n, PRF
+ * and F are SHA-256, and the rest is SHA-512.
+ * All the tweakable hashes start with PK.seed, padded out to a full block;
+ * as that's the same for every call, everyone computes the state after that
+ * block once, and so we don't count it.  Similarly, we assume that the HMAC
+ * in PRF_msg has its inner and outer key blocks precomputed
+ */
+static unsigned sha2_cost( int op, unsigned n, unsigned arg ) {
+    int big = (n > 16);
+    unsigned msg = COST_MSG_BYTES;
+    switch (op) {
+    case OP_PRF:                        /* ADRSc || SK.seed */
+    case OP_F:                          /* ADRSc || M (n bytes) */
+        return sha256_blocks( ADRSC_BYTES + n );
+    case OP_H:                          /* ADRSc || M (2n bytes) */
+        arg = 2;
+        /* FALL THROUGH */
+    case OP_T:                          /* ADRSc || M (arg * n bytes) */
+        return big ? sha512_blocks( ADRSC_BYTES + arg*n )
+                   : sha256_blocks( ADRSC_BYTES + arg*n );
+    case OP_H_MSG: {
+        /*
+         * MGF1( R || PK.seed || Hash( R || PK.seed || PK.root || M ), m )
+         * arg is m (the output length); each MGF1 output block is a hash of
+         * R || PK.seed || the inner hash || a 4 byte counter
+         */
+        unsigned hash_len = big ? 64 : 32;
+        unsigned inner = big ? sha512_blocks( 3*n + msg )
+                             : sha256_blocks( 3*n + msg );
+        unsigned outer = big ? sha512_blocks( 2*n + hash_len + 4 )
+                             : sha256_blocks( 2*n + hash_len + 4 );
+        return inner + outer * ((arg + hash_len - 1) / hash_len);
+    }
+    case OP_PRF_MSG:                    /* HMAC( SK.prf, opt_rand || M ) */
+        return big ? sha512_blocks( n + msg ) + sha512_blocks( 64 )
+                   : sha256_blocks( n + msg ) + sha256_blocks( 32 );
+    }
+    return 1;
+}
+
+/*
+ * The SHAKE versions: everything is SHAKE256 over the entire input, which
+ * starts with PK.seed and ADRS (except for H_msg and PRF_msg)
+ */
+static unsigned shake_cost( int op, unsigned n, unsigned arg ) {
+    unsigned msg = COST_MSG_BYTES;
+    switch (op) {
+    case OP_PRF:                        /* PK.seed || ADRS || SK.seed */
+    case OP_F:                          /* PK.seed || ADRS || M */
+        return shake256_blocks( n + ADRS_BYTES + n );
+    case OP_H:
+        return shake256_blocks( n + ADRS_BYTES + 2*n );
+    case OP_T:
+        return shake256_blocks( n + ADRS_BYTES + arg*n );
+    case OP_H_MSG:                      /* R || PK.seed || PK.root || M */
+        return shake256_blocks( 3*n + msg );
+    case OP_PRF_MSG:                    /* SK.prf || opt_rand || M */
+        return shake256_blocks( 2*n + msg );
+    }
+    return 1;
+}
+
+/*
+ * Return the cost of one hash operation, in compression function calls (or
+ * permutations), or in hashes for HASH_ABSTRACT
+ * n   - The hash size (in bytes)
+ * arg - For OP_T, how many n byte values are combined; for OP_H_MSG, the
+ *       number of bytes of digest; ignored for the others
+ */
+unsigned hash_op_cost( int hash, int op, unsigned n, unsigned arg ) {
+    switch (hash) {
+    case HASH_SHA2:  return sha2_cost( op, n, arg );
+    case HASH_SHAKE: return shake_cost( op, n, arg );
+    default:         return 1;
+    }
+}
+
+static const char *hash_names[] = { "abstract", "sha2", "shake" };
+
+/*
+ * Look up a hash function by name; returns -1 if we don't know it
+ */
+int hash_lookup( const char *name ) {
+    int i;
+    for (i=0; i<3; i++) {
+        if (0 == strcmp( name, hash_names[i] )) return i;
+    }
+    return -1;
+}
+
+const char *hash_name( int hash ) {
+    return hash_names[hash];
+}
+
+/*
+ * Which primitive a hash operation uses
+ */
+int hash_op_prim( int hash, int op, unsigned n ) {
+    if (hash == HASH_SHAKE) return PRIM_KECCAK;
+    if (n <= 16) return PRIM_SHA256;
+    return (op == OP_PRF || op == OP_F) ? PRIM_SHA256 : PRIM_SHA512;
+}
+
+/*
+ * How long each primitive takes on this host, in microseconds; [prim][0] is
+ * a single call, [prim][1] is the time per lane when we do a full set of
+ * lanes at once with the multi-buffer version
+ */
+static double prim_time[ NUM_PRIM ][ 2 ];
+
+static const char *prim_name[ NUM_PRIM ] = {
+    "SHA-256", "SHA-512", "Keccak-f1600"
+};
+
+static const int prim_lanes[ NUM_PRIM ] = {
+    SHA256_LANES, SHA512_LANES, KECCAK_LANES
+};
+
+#define BENCH_SECONDS 0.05  /* How long to time each primitive for */
+
+static double now( void ) {
+    struct timespec t;
+    clock_gettime( CLOCK_MONOTONIC, &t );
+    return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+/*
+ * Run the primitive reps times; we feed the output back into the input, so
+ * the compiler can't skip any of them
+ */
+static void run_prim( int prim, int multi, unsigned long reps ) {
+    static uint32_t s256[8][ SHA256_LANES ], s256_1[8];
+    static uint64_t s512[8][ SHA512_LANES ], s512_1[8];
+    static uint64_t keccak[25][ KECCAK_LANES ], keccak_1[25];
+    static unsigned char block[ 8 ][ 128 ];
+    const unsigned char *blocks[ 8 ];
+    unsigned long i;
+    int l;
+    for (l=0; l<8; l++) blocks[l] = block[l];
+
+    for (i=0; i<reps; i++) {
+        switch (prim) {
+        case PRIM_SHA256:
+            if (multi) sha256_compress_mb( s256, blocks );
+            else sha256_compress( s256_1, block[0] );
+            memcpy( block[0], multi ? s256[0] : s256_1, 4 );
+            break;
+        case PRIM_SHA512:
+            if (multi) sha512_compress_mb( s512, blocks );
+            else sha512_compress( s512_1, block[0] );
+            memcpy( block[0], multi ? s512[0] : s512_1, 8 );
+            break;
+        case PRIM_KECCAK:
+            if (multi) keccak_f1600_mb( keccak );
+            else keccak_f1600( keccak_1 );
+            break;
+        }
+    }
+}
+
+/*
+ * Time the primitives; we keep doubling the number of calls until it takes
+ * long enough to time accurately
+ */
+void calibrate_host( void ) {
+    int prim, multi;
+    for (prim = 0; prim < NUM_PRIM; prim++) {
+        for (multi = 0; multi < 2; multi++) {
+            unsigned long reps;
+            double elapsed;
+            run_prim( prim, multi, 100 );      /* Warm up */
+            for (reps = 1000; ; reps *= 2) {
+                double start = now();
+                run_prim( prim, multi, reps );
+                elapsed = now() - start;
+                if (elapsed >= BENCH_SECONDS) break;
+            }
+            prim_time[prim][multi] = 1e6 * elapsed / reps /
+                                         (multi ? prim_lanes[prim] : 1);
+        }
+        fprintf( stderr, "%-12s %8.4f us per call, %8.4f us per call with %d lanes\n",
+                 prim_name[prim], prim_time[prim][0], prim_time[prim][1],
+                 prim_lanes[prim] );
+    }
+}
+
+/*
+ * How long (in microseconds) a primitive takes on this host; multi says
+ * whether we're doing them a full set of lanes at a time
+ */
+double host_prim_time( int prim, int multi ) {
+    return prim_time[prim][ multi != 0 ];
+}
+
+int host_prim_lanes( int prim ) {
+    return prim_lanes[prim];
+}
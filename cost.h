@@ -0,0 +1,40 @@
+/*
+ * The hash functions we can cost the parameter sets for
+ */
+#define HASH_ABSTRACT 0     /* Every hash call costs 1 (the original model) */
+#define HASH_SHA2     1     /* Count SHA-256/SHA-512 compression calls */
+#define HASH_SHAKE    2     /* Count Keccak-f[1600] permutation calls */
+
+/*
+ * The hash operations SLH-DSA does (the names are the ones FIPS 205 uses)
+ */
+#define OP_PRF     0        /* Secret seed -> WOTS or FORS private value */
+#define OP_F       1        /* One step of a WOTS chain, or a FORS leaf */
+#define OP_H       2        /* A Merkle or FORS tree internal node */
+#define OP_T       3        /* Combining many values (WOTS pk, FORS roots) */
+#define OP_H_MSG   4        /* The message hash */
+#define OP_PRF_MSG 5        /* The randomizer */
+
+/*
+ * We cost the message hash as if the message were this long; that's what
+ * you get if you sign a digest (and otherwise, the message length is a
+ * cost the parameter set doesn't control)
+ */
+#define COST_MSG_BYTES 32
+
+int hash_lookup( const char *name );
+const char *hash_name( int hash );
+unsigned hash_op_cost( int hash, int op, unsigned n, unsigned arg );
+
+/*
+ * The primitives those hash operations are built from
+ */
+#define PRIM_SHA256 0
+#define PRIM_SHA512 1
+#define PRIM_KECCAK 2
+#define NUM_PRIM    3
+
+int hash_op_prim( int hash, int op, unsigned n );
+void calibrate_host( void );
+double host_prim_time( int prim, int multi );
+int host_prim_lanes( int prim );
@@ -0,0 +1,185 @@
+/*
+ * This is the program that lists the potential Sphincs+ parameter sets,
+ * given the target requirements (security level, number of signatures at
+ * that security level, overuse characteristics)
+ *
+ * This part of the program handles the curve store; a single binary file
+ * holding the overuse curves of all the listed parameter sets (see curves.h
+ * for the layout).  It also converts such a file back into the per-set CSV
+ * files that GnuPlot likes
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "curves.h"
+#include "writer.h"
+
+struct curve_store {
+    struct writer out;
+    char *filename;
+    uint64_t offset;            /* How much we've written so far */
+    struct curve_index *index;  /* The curves we've written */
+    unsigned num_curves, max_curves;
+};
+
+/*
+ * Start writing a curve file; returns NULL on failure
+ */
+struct curve_store *curve_store_open( const char *filename ) {
+    struct curve_store *store = malloc( sizeof *store );
+    FILE *f = fopen( filename, "wb" );
+    if (!store || !f) {
+        fprintf( stderr, "Unable to open %s\n", filename );
+        if (f) fclose( f );
+        free( store );
+        return 0;
+    }
+    writer_init( &store->out, f );
+    store->filename = strdup( filename );
+    store->index = 0;
+    store->num_curves = store->max_curves = 0;
+
+    /* Leave room for the header; we fill it in once we know where the */
+    /* index goes */
+    struct curve_header header = { { 0 }, 0, 0, 0 };
+    write_bytes( &store->out, &header, sizeof header );
+    store->offset = sizeof header;
+    return store;
+}
+
+/*
+ * Write an array of doubles (which keeps us on an 8 byte boundary); returns
+ * where it was written
+ */
+static uint64_t write_doubles( struct curve_store *store, const double *v,
+                               unsigned count ) {
+    uint64_t where = store->offset;
+    size_t len = count * sizeof *v;
+    write_bytes( &store->out, v, len );
+    store->offset += len;
+    return where;
+}
+
+/*
+ * Add a curve to the file
+ */
+void curve_store_add( struct curve_store *store, const char *id,
+                      unsigned h, unsigned d, unsigned a, unsigned k,
+                      unsigned w, unsigned num_points,
+                      const double *x, const double *y ) {
+    if (store->num_curves == store->max_curves) {
+        unsigned new_max = store->max_curves ? 2*store->max_curves : 64;
+        struct curve_index *p = realloc( store->index,
+                                         new_max * sizeof *p );
+        if (!p) {
+            fprintf( stderr, "Get a real computer you cheapskate\n" );
+            return;
+        }
+        store->index = p;
+        store->max_curves = new_max;
+    }
+    struct curve_index *entry = &store->index[ store->num_curves++ ];
+    memset( entry, 0, sizeof *entry );
+    strncpy( entry->id, id, sizeof entry->id - 1 );
+    entry->h = h; entry->d = d; entry->a = a; entry->k = k; entry->w = w;
+    entry->num_points = num_points;
+    entry->x_offset = write_doubles( store, x, num_points );
+    entry->y_offset = write_doubles( store, y, num_points );
+}
+
+/*
+ * Write out the index, and fill in the header.  Returns 0 on failure
+ */
+int curve_store_close( struct curve_store *store ) {
+    struct curve_header header;
+    memcpy( header.magic, CURVE_MAGIC, sizeof header.magic );
+    header.version = CURVE_VERSION;
+    header.num_curves = store->num_curves;
+    header.index_offset = store->offset;
+
+    write_bytes( &store->out, store->index,
+                 store->num_curves * sizeof *store->index );
+    int ok = writer_flush( &store->out );
+    if (ok && (0 != fseek( store->out.f, 0, SEEK_SET ) ||
+               1 != fwrite( &header, sizeof header, 1, store->out.f ))) {
+        ok = 0;
+    }
+    if (0 != fclose( store->out.f )) ok = 0;
+    if (!ok) fprintf( stderr, "Error writing %s\n", store->filename );
+
+    free( store->filename );
+    free( store->index );
+    free( store );
+    return ok;
+}
+
+/*
+ * Convert a curve file into the CSV files we'd have written without it;
+ * that is, <id>.csv for each curve, with one "x, y" line per point
+ * Returns 0 on failure
+ */
+int curves_to_csv( const char *filename ) {
+    int fd = open( filename, O_RDONLY );
+    struct stat st;
+    if (fd < 0 || 0 != fstat( fd, &st )) {
+        fprintf( stderr, "Unable to open %s\n", filename );
+        if (fd >= 0) close( fd );
+        return 0;
+    }
+    size_t size = st.st_size;
+    const char *base = size ? mmap( 0, size, PROT_READ, MAP_PRIVATE, fd, 0 )
+                            : MAP_FAILED;
+    close( fd );
+    if (base == MAP_FAILED) {
+        fprintf( stderr, "Unable to read %s\n", filename );
+        return 0;
+    }
+
+    const struct curve_header *header = (const void *)base;
+    int ok = 1;
+    if (size < sizeof *header ||
+            0 != memcmp( header->magic, CURVE_MAGIC, sizeof header->magic ) ||
+            header->version != CURVE_VERSION ||
+            header->index_offset > size ||
+            header->num_curves > (size - header->index_offset) /
+                                       sizeof (struct curve_index)) {
+        fprintf( stderr, "%s is not a curve file\n", filename );
+        ok = 0;
+    }
+
+    unsigned i;
+    for (i = 0; ok && i < header->num_curves; i++) {
+        const struct curve_index *entry = (const void *)
+            (base + header->index_offset + i * sizeof (struct curve_index));
+        uint64_t len = (uint64_t)entry->num_points * sizeof (double);
+        if (entry->x_offset > size || len > size - entry->x_offset ||
+            entry->y_offset > size || len > size - entry->y_offset) {
+            fprintf( stderr, "%s is corrupt\n", filename );
+            ok = 0;
+            break;
+        }
+        const double *x = (const void *)(base + entry->x_offset);
+        const double *y = (const void *)(base + entry->y_offset);
+
+        char csv_name[sizeof entry->id + 10];
+        sprintf( csv_name, "%.*s.csv", (int)sizeof entry->id, entry->id );
+        FILE *f = fopen( csv_name, "w" );
+        if (!f) {
+            fprintf( stderr, "Unable to open %s\n", csv_name );
+            ok = 0;
+            break;
+        }
+        unsigned j;
+        for (j = 0; j < entry->num_points; j++) {
+            fprintf( f, "%f, %f\n", x[j], y[j] );
+        }
+        fclose( f );
+    }
+
+    munmap( (void *)base, size );
+    return ok;
+}
@@ -0,0 +1,38 @@
+#include <stdint.h>
+
+/*
+ * The layout of the curves= file: the overuse curves of all the listed
+ * parameter sets in a single file, in a form that can be memory mapped
+ * It is a curve_header, followed by the points of each curve (all the x
+ * values as doubles, and then all the y values), followed by the index
+ * (num_curves curve_index entries, at index_offset).  Everything is in the
+ * host byte order, and every array starts on an 8 byte boundary
+ */
+#define CURVE_MAGIC   "SPXCURV1"
+#define CURVE_VERSION 1
+
+struct curve_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_curves;
+    uint64_t index_offset;      /* Where the index starts */
+};
+
+struct curve_index {
+    char id[24];                /* The parameter set ID, e.g. "A-3" */
+    uint16_t h, d, a, k, w;     /* The parameter set */
+    uint16_t reserved;
+    uint32_t num_points;
+    uint64_t x_offset;          /* Where double x[num_points] starts */
+    uint64_t y_offset;          /* Where double y[num_points] starts */
+};
+
+struct curve_store;
+
+struct curve_store *curve_store_open( const char *filename );
+void curve_store_add( struct curve_store *store, const char *id,
+                      unsigned h, unsigned d, unsigned a, unsigned k,
+                      unsigned w, unsigned num_points,
+                      const double *x, const double *y );
+int curve_store_close( struct curve_store *store );
+int curves_to_csv( const char *filename );
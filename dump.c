@@ -0,0 +1,81 @@
+/*
+ * This is the program that lists the potential Sphincs+ parameter sets,
+ * given the target requirements (security level, number of signatures at
+ * that security level, overuse characteristics)
+ *
+ * This part of the program writes the dump= file; every parameter set the
+ * search found acceptable, as fixed size records (see dump.h for the
+ * layout).  There can be millions of them, so we collect the records in a
+ * large buffer, and write them out a buffer at a time
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dump.h"
+#include "writer.h"
+
+struct dump_file {
+    struct writer out;
+    char *filename;
+    struct dump_header header;
+};
+
+/*
+ * Start writing a dump file; returns NULL on failure.  The parameters are
+ * the ones the search was run with; we record them in the header
+ */
+struct dump_file *dump_open( const char *filename, unsigned sec_level,
+                             unsigned num_sig, unsigned test_sec_level,
+                             unsigned sign_op, unsigned hash ) {
+    struct dump_file *dump = malloc( sizeof *dump );
+    FILE *f = fopen( filename, "wb" );
+    if (!dump || !f) {
+        fprintf( stderr, "Unable to open %s\n", filename );
+        if (f) fclose( f );
+        free( dump );
+        return 0;
+    }
+    writer_init( &dump->out, f );
+    dump->filename = strdup( filename );
+
+    memset( &dump->header, 0, sizeof dump->header );
+    memcpy( dump->header.magic, DUMP_MAGIC, sizeof dump->header.magic );
+    dump->header.version = DUMP_VERSION;
+    dump->header.record_size = sizeof (struct dump_record);
+    dump->header.sec_level = sec_level;
+    dump->header.num_sig = num_sig;
+    dump->header.test_sec_level = test_sec_level;
+    dump->header.sign_op = sign_op;
+    dump->header.hash = hash;
+
+    /* We write the header now (so the records land in the right place), */
+    /* and rewrite it once we know how many records there are */
+    write_bytes( &dump->out, &dump->header, sizeof dump->header );
+    return dump;
+}
+
+/*
+ * Add a parameter set to the file
+ */
+void dump_add( struct dump_file *dump, const struct dump_record *rec ) {
+    write_bytes( &dump->out, rec, sizeof *rec );
+    dump->header.num_records++;
+}
+
+/*
+ * Flush the records, and fill in the header.  Returns 0 on failure
+ */
+int dump_close( struct dump_file *dump ) {
+    int ok = writer_flush( &dump->out );
+    if (ok && (0 != fseek( dump->out.f, 0, SEEK_SET ) ||
+               1 != fwrite( &dump->header, sizeof dump->header, 1,
+                            dump->out.f ))) {
+        ok = 0;
+    }
+    if (0 != fclose( dump->out.f )) ok = 0;
+    if (!ok) fprintf( stderr, "Error writing %s\n", dump->filename );
+
+    free( dump->filename );
+    free( dump );
+    return ok;
+}
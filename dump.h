@@ -0,0 +1,73 @@
+#include <stdint.h>
+
+/*
+ * The layout of the dump= file: every parameter set the search found that
+ * meets the security requirement (not just the ones we list), so that they
+ * can be analyzed (ranked differently, plotted, compared between runs)
+ * without rerunning the search
+ * It is a dump_header, followed by num_records fixed size dump_records, in
+ * the order the search found them.  Everything is in the host byte order;
+ * the file is designed to be memory mapped
+ */
+#define DUMP_MAGIC   "SPXDUMP1"
+#define DUMP_VERSION 1
+
+struct dump_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;       /* sizeof (struct dump_record) */
+    uint64_t num_records;
+    uint32_t sec_level;         /* The search that produced this */
+    uint32_t num_sig;
+    uint32_t test_sec_level;
+    uint32_t sign_op;
+    uint32_t hash;              /* What the costs are in (see cost.h) */
+    uint32_t reserved;
+};
+
+struct dump_record {
+    uint8_t h;                  /* Hypertree height */
+    uint8_t d;                  /* Number of Merkle tree layers */
+    uint8_t a;                  /* Height of each FORS tree */
+    uint8_t k;                  /* Number of FORS trees */
+    uint8_t n;                  /* Hash size (bytes) */
+    uint8_t m;                  /* Message digest size (bytes) */
+    uint16_t w;                 /* Winternitz parameter */
+    uint32_t sig_size;          /* Signature size (bytes) */
+    uint32_t sig_time;          /* Hashes computed during signing */
+    uint32_t ver_time;          /* Hashes computed during verification */
+                                /* (or compression calls or permutations, */
+                                /* depending on header.hash) */
+    uint32_t reserved;
+};
+
+/*
+ * The query= mode keeps indexes of a dump file in <file>.idx (building it
+ * the first time, or when the dump changes).  That is a dump_index_header,
+ * followed by DUMP_NUM_INDEX arrays of num_records uint32_t record numbers;
+ * each array lists the records in increasing order of one field (sig_size,
+ * sig_time, ver_time, h and a, in that order)
+ */
+#define DUMP_INDEX_MAGIC   "SPXINDX1"
+#define DUMP_INDEX_VERSION 1
+#define DUMP_NUM_INDEX     5
+
+struct dump_index_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_index;         /* DUMP_NUM_INDEX */
+    uint64_t num_records;       /* These describe the dump file the index */
+    uint64_t dump_size;         /* was built from; if it no longer */
+    int64_t dump_mtime;         /* matches, we rebuild the index */
+    int64_t dump_mtime_ns;      /* (the mtime is to the nanosecond, as a */
+                                /* dump rewritten within the same second */
+                                /* is usually the same size) */
+};
+
+struct dump_file;
+
+struct dump_file *dump_open( const char *filename, unsigned sec_level,
+                             unsigned num_sig, unsigned test_sec_level,
+                             unsigned sign_op, unsigned hash );
+void dump_add( struct dump_file *dump, const struct dump_record *rec );
+int dump_close( struct dump_file *dump );
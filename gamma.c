@@ -6,11 +6,13 @@
  * This part of the program computes the actual security level, that is,
  * it evaluates equation (1) of the paper
  */
+#include <stdio.h>
 #include <math.h>
 #include <ctype.h>
+#include <string.h>
+#include <time.h>
 #include "gamma.h"
 
-#if 0
 /*
  * This is a straightfoward implementation of algorithm (1)
  * It works fine for reasonable inputs; however it runs into floating point
@@ -18,9 +20,11 @@
  * drastic overuse conditions
  *
  * It is here because it should be helpful to compare this implementation with
- * the rather less straightforward implementation we use below
+ * the rather less straightforward implementation we use below.  Also, where
+ * it is valid (see direct_valid), calibration may find it to be the faster
+ * one
  */
-double compute_sec_level( double m, int H, int T, int K ) {
+static double compute_sec_level_direct( double m, int H, int T, int K ) {
     double lambda;
     if (m > H) {
         lambda = pow(2, m-H);
@@ -49,34 +53,150 @@ double compute_sec_level( double m, int H, int T, int K ) {
     return -log2( exp( -lambda ) * sum );
 }
 
-#else
+/*
+ * Return whether compute_sec_level_direct can be trusted with these inputs
+ * Outside of here, either exp(-lambda) or the first term (which is about
+ * 2^{-TK}) gets too close to underflowing
+ */
+static int direct_valid( double m, int H, int T, int K ) {
+    return m - H <= 4 && m - H >= -40 && T*K <= 900;
+}
 
 /*
- * This is an alternate implementation designed to work in drastic overuse
- * conditions (and also in normal ones as well).  It keeps most things in
- * logarithmic form, that is, log_2 of the 'actual' value - this avoids
- * overflows (and at the one point where we might lose significance, we
- * have explicit code handling that)
+ * The implementation we actually use is in gamma_kernel.h; it is designed to
+ * work in drastic overuse conditions (and also in normal ones as well).  We
+ * build it several times, once for each instruction set we know about, and
+ * pick the one to use when we start up (based on what the CPU supports).
+ * That way, the same executable runs everywhere, and still makes use of the
+ * vector units when they're there
  */
+#define BATCH_MAX 128   /* The most K values check_sec_level_batch */
+                        /* evaluates in a single pass */
+
+#define KERNEL(name) name##_scalar
+#include "gamma_kernel.h"
+#undef KERNEL
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HAVE_X86_KERNELS
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#define KERNEL(name) name##_avx2
+#include "gamma_kernel.h"
+#undef KERNEL
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq,avx512vl,avx2,fma")
+#define KERNEL(name) name##_avx512
+#include "gamma_kernel.h"
+#undef KERNEL
+#pragma GCC pop_options
+#endif
 
-/* Add two values in log2 representation */
-/* That is, given log2(a), log2(b), this returns log2(a+b) */
-static double do_add(double x, double y) {
-    double big, little;
-    if (x > y) {
-        big = x; little = y;
-    } else {
-        big = y; little = x;
+/*
+ * The kernels we can pick from
+ */
+struct gamma_kernels {
+    const char *name;
+    int (*supported)(void);
+    double (*compute_sec_level)( double m, int H, int T, int K );
+    int (*check_sec_level)( double m, int H, int T, int K, double sec_level );
+    void (*check_sec_level_batch)( double m, int H, int T,
+                                  int k_first, int count, double sec_level,
+                                  unsigned char *ok );
+};
+
+static int always(void) { return 1; }
+#ifdef HAVE_X86_KERNELS
+static int have_avx2(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" );
+}
+static int have_avx512(void) {
+    __builtin_cpu_init();
+    return have_avx2() && __builtin_cpu_supports( "avx512f" ) &&
+           __builtin_cpu_supports( "avx512dq" ) &&
+           __builtin_cpu_supports( "avx512vl" );
+}
+#endif
+
+/* Best first; auto-detection picks the first one the CPU supports */
+static const struct gamma_kernels kernel_list[] = {
+#ifdef HAVE_X86_KERNELS
+    { "avx512", have_avx512, compute_sec_level_avx512, check_sec_level_avx512,
+                             check_sec_level_batch_avx512 },
+    { "avx2",   have_avx2,   compute_sec_level_avx2,   check_sec_level_avx2,
+                             check_sec_level_batch_avx2 },
+#endif
+    { "scalar", always,      compute_sec_level_scalar, check_sec_level_scalar,
+                             check_sec_level_batch_scalar },
+};
+#define NUM_KERNELS (sizeof kernel_list / sizeof *kernel_list)
+
+static const struct gamma_kernels *kernel;  /* The one we're using; NULL */
+                                            /* if we haven't picked yet */
+static int calibrated;      /* Set if we've calibrated; in that case, we */
+                            /* use the per-regime maps (below) instead */
+
+/*
+ * Select which kernels to use.  "auto" (or NULL) picks the best one this CPU
+ * supports; otherwise, it is the name of a specific one (which is useful if
+ * we want to benchmark them against each other)
+ * This returns 0 if the requested kernel isn't known, or if this CPU can't
+ * run it
+ */
+int gamma_select_isa( const char *name ) {
+    unsigned i;
+    for (i=0; i<NUM_KERNELS; i++) {
+        if (name && 0 != strcmp( name, "auto" ) &&
+                    0 != strcmp( name, kernel_list[i].name )) continue;
+        if (!kernel_list[i].supported()) {
+            if (!name || 0 == strcmp( name, "auto" )) continue;
+            return 0;
+        }
+        kernel = &kernel_list[i];
+        calibrated = 0;     /* An explicit choice overrides calibration */
+        return 1;
     }
-    if (big > little + 64) return big;  /* If a > b * 2^64, then log2(a+b) */
-                                        /* is essentially log2(a) */
+    return 0;
+}
 
-    double temp = 1 + pow( 0.5, big - little ); /* temp = 1 + b/a (assuming */
-                                        /* a >= b, otherwise swap them) */
+/*
+ * Return the name of the kernel we're using
+ */
+const char *gamma_isa_name( void ) {
+    if (!kernel) gamma_select_isa( 0 );
+    return kernel->name;
+}
 
-    return big + log2( temp );  /* big+log2(temp) = log(a) + log2(1 + b/a) */
-                                /*                = log( a*(1+b/a) ) */
-                                /* (assuming a >= b, otherwise swap them) */
+/*
+ * Which evaluator is fastest depends on the regime (how many signatures per
+ * hypertree leaf we're looking at, and how many FORS trees there are), as
+ * well as the CPU.  If asked, we calibrate: time each evaluator on a grid of
+ * regimes, and record the fastest for each in these maps.  They hold an
+ * index into kernel_list (or EVAL_DIRECT for compute_sec_level_direct),
+ * which the evaluation routines below consult for the rest of the run
+ */
+#define NUM_LAMBDA_REGIMES 16   /* log2(lambda) from -8 (or less) to 7+ */
+#define NUM_K_REGIMES       4   /* K < 16, < 32, < 64, and the rest */
+#define EVAL_DIRECT ((int)NUM_KERNELS)
+static signed char compute_map[ NUM_LAMBDA_REGIMES ][ NUM_K_REGIMES ];
+static signed char check_map[ NUM_LAMBDA_REGIMES ][ NUM_K_REGIMES ];
+
+static int lambda_regime( double m, int H ) {
+    int r = (int)floor( m - H ) + 8;
+    if (r < 0) r = 0;
+    if (r >= NUM_LAMBDA_REGIMES) r = NUM_LAMBDA_REGIMES-1;
+    return r;
+}
+
+static int k_regime( int K ) {
+    if (K < 16) return 0;
+    if (K < 32) return 1;
+    if (K < 64) return 2;
+    return 3;
 }
 
 /*
@@ -84,194 +204,383 @@ static double do_add(double x, double y) {
  * the hypertree has H levels, and that we have K FORS trees of height T
  */
 double compute_sec_level( double m, int H, int T, int K ) {
-    /*
-     * Compute lambda which is the expected number of signatures per hypertree
-     * leaf at the specified number of signatures
-     */
-    double lambda;
-    if (m > H) {
-        lambda = pow(2, m-H);
-    } else {
-        lambda = pow(0.5, H-m);
+    if (calibrated) {
+        int e = compute_map[ lambda_regime(m, H) ][ k_regime(K) ];
+        if (e != EVAL_DIRECT) {
+            return kernel_list[e].compute_sec_level( m, H, T, K );
+        }
+        if (direct_valid( m, H, T, K )) {
+            return compute_sec_level_direct( m, H, T, K );
+        }
+    }
+    if (!kernel) gamma_select_isa( 0 );
+    return kernel->compute_sec_level( m, H, T, K );
+}
+
+/*
+ * This does a quick test of whether, after pow(2,m) signatures, the
+ * specified Sphincs+ structure will meet the specified security level
+ */
+int check_sec_level( double m, int H, int T, int K, double sec_level ) {
+    if (calibrated) {
+        int e = check_map[ lambda_regime(m, H) ][ k_regime(K) ];
+        return kernel_list[e].check_sec_level( m, H, T, K, sec_level );
     }
-    double log_lambda = log2(lambda);   /* ... or m-H */
+    if (!kernel) gamma_select_isa( 0 );
+    return kernel->check_sec_level( m, H, T, K, sec_level );
+}
 
-    double prob_not_get_single_hit = 1.0 - pow(0.5, T); /* This is */
-        /* the probability that a probe does not hit a specific valid */
-        /* signature within a specific FORS tree */
-    double prob_not_get_g_hit = 1.0;  /* This is the probability that */
-        /* no probes hit a specific valid signature in a specific FORS tree */
-        /* after g signatures have been generated from this FORS */
-        /* This is updated as g is iterated */
+/*
+ * This does check_sec_level for each of K = k_first .. k_first+count-1,
+ * placing the results in ok[0] .. ok[count-1]
+ */
+void check_sec_level_batch( double m, int H, int T, int k_first, int count,
+                            double sec_level, unsigned char *ok ) {
+    if (calibrated) {
+        int e = check_map[ lambda_regime(m, H) ][ k_regime(k_first + count/2) ];
+        kernel_list[e].check_sec_level_batch( m, H, T, k_first, count,
+                                              sec_level, ok );
+        return;
+    }
+    if (!kernel) gamma_select_isa( 0 );
+    kernel->check_sec_level_batch( m, H, T, k_first, count, sec_level, ok );
+}
 
-    double log_a = 0.0;    /* a == lambda^g */
-    double log_sum = 0.0;  /* the running sum */
+/*
+ * Does the direct formula give the same answers as the reference (the
+ * first series kernel, which is always valid) everywhere in this regime
+ * the search can ask about?  That's every FORS tree height (1 to 29) and
+ * every number of FORS trees in the K regime (up to 99), at the bottom,
+ * middle and top of the lambda regime (the bottom one goes down to where
+ * direct_valid stops, and the top one can't be used at all).  Only lambda
+ * (that is, m-H) matters, not H itself.  We skip the points where
+ * direct_valid doesn't let it be used; we don't use it there anyway
+ */
+static int direct_agrees( int lr, int kr ) {
+    static const int k_first[ NUM_K_REGIMES ] = { 1, 16, 32, 64 };
+    static const int k_last[ NUM_K_REGIMES ] = { 15, 31, 63, 99 };
+    static const double offset[] = { 0, 0.5, 0.999 };
+    int H = 40, T, K;
+    unsigned i;
+    for (i=0; i<sizeof offset / sizeof *offset; i++) {
+        double m = H + (lr - 8) + offset[i];
+        if (lr == 0) m = H - 40 + 32.999 * offset[i] / 0.999;
+        for (T = 1; T < 30; T++) {
+            for (K = k_first[kr]; K <= k_last[kr]; K++) {
+                if (!direct_valid( m, H, T, K )) continue;
+                double ref = compute_sec_level_scalar( m, H, T, K );
+                double r = compute_sec_level_direct( m, H, T, K );
+                if (!(fabs( r - ref ) <= 1e-9 * fabs( ref ))) return 0;
+            }
+        }
+    }
+    return 1;
+}
 
-    for (unsigned g = 1;; g++) {
-            /* Update the variables that depend on g */
-        log_a += log_lambda;
-        log_a -= log2(g);
-        prob_not_get_g_hit *= prob_not_get_single_hit;
+/*
+ * Return the time (in seconds) it takes to evaluate a sample of points
+ * within the given regime, with the given evaluator.  If the evaluator
+ * doesn't give the same answers as the reference one (see direct_agrees;
+ * the kernels all do), this returns HUGE_VAL
+ */
+#define CALIBRATE_REPS 8
+static double time_evaluator( int e, int check, int lr, int kr ) {
+    static const int sample_T[] = { 6, 10, 14 };
+    static const int sample_K[ NUM_K_REGIMES ] = { 8, 24, 48, 80 };
+    int H = 40;
+    double m = H + (lr - 8) + 0.5;
+    int K = sample_K[kr];
+    unsigned i, rep;
+    volatile double sink = 0;
+
+    /* Check that it gives the right answers in this regime */
+    if (e == EVAL_DIRECT) {
+        for (i=0; i<sizeof sample_T / sizeof *sample_T; i++) {
+            if (!direct_valid( m, H, sample_T[i], K )) return HUGE_VAL;
+        }
+        if (!direct_agrees( lr, kr )) return HUGE_VAL;
+    }
 
-        /*
-         * a is the probability that there will be precisely g valid signatures
-         * for this FORS (except for the constant e^{-\lambda} term; we'll
-         * account for that at the end)
-         */
-        
-        /*
-         * Compute b which is probability that a single forgery query will lie
-         * entirely in revealed FORS leaves (and thus will allow a signature
-         * of that forgery), assuming we have precisely g valid signatures for
-         * this FORS
-         */
-        double log_b;
-        if (prob_not_get_g_hit < 1E-5) {
-            /*
-             * If prob_not_get_g_hit is sufficiently small, the subtraction
-             * will lose significant bits (or just result in 1)
-             * In this regime, the quadratic approximation, that is, the first
-             * two terms in the Taylor expansion, gives us a more accurate
-	     * value
-             */
-            log_b = -K * (prob_not_get_g_hit / log(2.0) + 
-	               prob_not_get_g_hit*prob_not_get_g_hit / (2*log(2.0)));
-        } else {
-            /*
-             * prob_not_get_g_hit is still large enough; compute it directly
-             */
-            log_b = K * log2( 1 - prob_not_get_g_hit );
+    struct timespec start, stop;
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    for (rep = 0; rep < CALIBRATE_REPS; rep++) {
+        for (i=0; i<sizeof sample_T / sizeof *sample_T; i++) {
+            int T = sample_T[i];
+            if (check) {
+                /* Test against a level near the actual one; that's where */
+                /* the early outs take the longest to kick in */
+                double level = 1 + compute_sec_level_scalar( m, H, T, K ) - rep%2;
+                sink += kernel_list[e].check_sec_level( m, H, T, K, level );
+            } else if (e == EVAL_DIRECT) {
+                sink += compute_sec_level_direct( m, H, T, K );
+            } else {
+                sink += kernel_list[e].compute_sec_level( m, H, T, K );
+            }
         }
+    }
+    clock_gettime( CLOCK_MONOTONIC, &stop );
+    (void)sink;
 
-        /*
-         * Hence, the probability that this iteration adds to the sum is
-         * a*b, and since we're dealing with logs, log(ab) = log(a) + log(b)
-         */
+    return (stop.tv_sec - start.tv_sec) + 1e-9 * (stop.tv_nsec - start.tv_nsec);
+}
 
-        if (g == 1) {
-            /* For the first iteration, the running sum is the first output */
-            log_sum = log_a+log_b;
-        } else {
-            /* For latter iterations, add log(ab) to the running sum */
-            log_sum = do_add(log_sum, log_a+log_b);
+/*
+ * Time each evaluator on each regime, and fill in the maps with the fastest
+ */
+static void calibrate( void ) {
+    int lr, kr, e;
+    for (lr = 0; lr < NUM_LAMBDA_REGIMES; lr++) {
+        for (kr = 0; kr < NUM_K_REGIMES; kr++) {
+            double best_compute = HUGE_VAL, best_check = HUGE_VAL;
+            compute_map[lr][kr] = check_map[lr][kr] = NUM_KERNELS-1;
+            for (e = 0; e <= EVAL_DIRECT; e++) {
+                if (e != EVAL_DIRECT && !kernel_list[e].supported()) continue;
+                double t = time_evaluator( e, 0, lr, kr );
+                if (t < best_compute) {
+                    best_compute = t;
+                    compute_map[lr][kr] = e;
+                }
+                if (e == EVAL_DIRECT) continue;  /* No check version */
+                t = time_evaluator( e, 1, lr, kr );
+                if (t < best_check) {
+                    best_check = t;
+                    check_map[lr][kr] = e;
+                }
+            }
         }
+    }
+    calibrated = 1;
+}
 
-        /*
-         * If the additional terms we're seeing is less than 2^{-20} of the
-         * sum, any further terms won't change the answer much - we might as
-         * well stop.  We test against log_a, as that is strictly decreasing
-         * and bounds the probability (as log_b < 0)
-         */
-        if (g >= 10 && log_sum > 20 + log_a ) break;
+static const char *evaluator_name( int e ) {
+    return e == EVAL_DIRECT ? "direct" : kernel_list[e].name;
+}
+
+/*
+ * Look up an evaluator by name; returns -1 if we don't know it (or the CPU
+ * can't run it)
+ */
+static int evaluator_index( const char *name ) {
+    int e;
+    if (0 == strcmp( name, "direct" )) return EVAL_DIRECT;
+    for (e = 0; e < (int)NUM_KERNELS; e++) {
+        if (0 == strcmp( name, kernel_list[e].name )) {
+            return kernel_list[e].supported() ? e : -1;
+        }
     }
+    return -1;
+}
 
-    /*
-     * Return the -log2 of the total probability, that is, the expected
-     * security level.  And, since we didn't include the e^{-\lambda} constant
-     * term in 'a', we add it in now
-     */
-    return lambda * log2( exp( 1 )) - log_sum;
+#define CALIBRATION_MAGIC "sphincs-search calibration 1"
+
+/*
+ * Read the maps from a calibration file.  Returns 0 if the file isn't there,
+ * or doesn't cover every regime with evaluators we can use
+ */
+static int load_calibration( const char *filename ) {
+    FILE *f = fopen( filename, "r" );
+    if (!f) return 0;
+
+    char line[100];
+    int seen = 0;
+    if (!fgets( line, sizeof line, f ) ||
+              0 != strncmp( line, CALIBRATION_MAGIC, strlen(CALIBRATION_MAGIC) )) {
+        fclose(f);
+        return 0;
+    }
+    char kind[20], name[20];
+    int lr, kr;
+    while (4 == fscanf( f, "%19s %d %d %19s", kind, &lr, &kr, name )) {
+        int e = evaluator_index( name );
+        if (e < 0 || lr < 0 || lr >= NUM_LAMBDA_REGIMES ||
+                     kr < 0 || kr >= NUM_K_REGIMES) break;
+        if (0 == strcmp( kind, "compute" )) {
+            compute_map[lr][kr] = e;
+        } else if (0 == strcmp( kind, "check" ) && e != EVAL_DIRECT) {
+            check_map[lr][kr] = e;
+        } else {
+            break;
+        }
+        seen++;
+    }
+    fclose(f);
+    return seen == 2 * NUM_LAMBDA_REGIMES * NUM_K_REGIMES;
+}
+
+static void save_calibration( const char *filename ) {
+    FILE *f = fopen( filename, "w" );
+    if (!f) {
+        fprintf( stderr, "Unable to open %s\n", filename );
+        return;
+    }
+    fprintf( f, "%s\n", CALIBRATION_MAGIC );
+    int lr, kr;
+    for (lr = 0; lr < NUM_LAMBDA_REGIMES; lr++) {
+        for (kr = 0; kr < NUM_K_REGIMES; kr++) {
+            fprintf( f, "compute %d %d %s\n", lr, kr,
+                                   evaluator_name( compute_map[lr][kr] ));
+            fprintf( f, "check %d %d %s\n", lr, kr,
+                                   evaluator_name( check_map[lr][kr] ));
+        }
+    }
+    fclose(f);
 }
-#endif
 
 /*
- * This does a quick test of whether, after pow(2,m) signatures, the
- * specified Sphincs+ structure will meet the specified security level
- * It does early outs (either way) when it is clear what the answer is, hence
- * it is cheaper than computing the exact security level
+ * Set up the per-regime evaluator maps.  If filename is given, and it holds
+ * a valid calibration, we use that; otherwise we calibrate now (and, if we
+ * were given a filename, we store the result there for next time)
  */
-int check_sec_level( double m, int H, int T, int K, double sec_level ) {
-    /*
-     * Compute lambda which is the expected number of signatures per hypertree
-     * leaf at the specified number of signatures
-     */
-    double lambda;
-    if (m > H) {
-        lambda = pow(2, m-H);
-    } else {
-        lambda = pow(0.5, H-m);
+void gamma_calibrate( const char *filename ) {
+    if (filename && load_calibration( filename )) {
+        calibrated = 1;
+        return;
     }
-    double log_lambda = log2(lambda);   /* ... or m-H */
-    double log_target = log2(exp(lambda)) - sec_level;  /* If log_sum */
-               /* exeeds this, we know we didn't hit the security level */
+    calibrate();
+    if (filename) save_calibration( filename );
+}
 
-    double prob_not_get_single_hit = 1.0 - pow(0.5, T); /* This is */
-        /* the probability that a probe does not hit a specific valid */
-        /* signature within a specific FORS tree */
-    double prob_not_get_g_hit = 1.0;  /* This is the probability that */
-        /* no probes hit a specific valid signature in a specific FORS tree */
-        /* after g signatures have been generated from this FORS */
-        /* This is updated as g is iterated */
+/*
+ * These give the validation harness access to each evaluator individually
+ * Evaluators are numbered 0 .. gamma_num_evaluators()-1; the kernels first
+ * (in kernel_list order), and then the direct formula
+ */
+int gamma_num_evaluators( void ) {
+    return EVAL_DIRECT + 1;
+}
+
+const char *gamma_evaluator_name( int e ) {
+    return evaluator_name( e );
+}
 
-    double log_a = 0.0;    /* a == lambda^g */
-    double log_sum = 0.0;  /* the running sum */
+/* Returns whether this CPU can run the evaluator */
+int gamma_evaluator_supported( int e ) {
+    return e == EVAL_DIRECT || kernel_list[e].supported();
+}
 
-    for (unsigned g = 1;; g++) {
-            /* Update the variables that depend on g */
-        log_a += log_lambda;
-        log_a -= log2(g);
-        prob_not_get_g_hit *= prob_not_get_single_hit;
+/*
+ * compute_sec_level with a specific evaluator.  This returns NAN if the
+ * evaluator isn't valid for these inputs
+ */
+double gamma_evaluate( int e, double m, int H, int T, int K ) {
+    if (e == EVAL_DIRECT) {
+        if (!direct_valid( m, H, T, K )) return NAN;
+        return compute_sec_level_direct( m, H, T, K );
+    }
+    return kernel_list[e].compute_sec_level( m, H, T, K );
+}
+
+/*
+ * check_sec_level (and check_sec_level_batch) with a specific evaluator
+ * These return -1 if the evaluator doesn't have a check version
+ */
+int gamma_evaluate_check( int e, double m, int H, int T, int K,
+                          double sec_level ) {
+    if (e == EVAL_DIRECT) return -1;
+    return kernel_list[e].check_sec_level( m, H, T, K, sec_level );
+}
+
+int gamma_evaluate_check_batch( int e, double m, int H, int T, int k_first,
+                                int count, double sec_level,
+                                unsigned char *ok ) {
+    if (e == EVAL_DIRECT) return -1;
+    kernel_list[e].check_sec_level_batch( m, H, T, k_first, count,
+                                          sec_level, ok );
+    return 0;
+}
 
-        /*
-         * a is the probability that there will be precisely g valid signatures
-         * for this FORS (except for the constant e^{-\lambda} term; we'll
-         * account for that at the end)
-         */
-        
-        /*
-         * Compute b which is probability that a single forgery query will lie
-         * entirely in revealed FORS leaves (and thus will allow a signature
-         * of that forgery), assuming we have precisely g valid signatures for
-         * this FORS
-         */
-        double log_b;
-        if (prob_not_get_g_hit < 1E-5) {
-            /*
-             * If prob_not_get_g_hit is sufficiently small, the subtraction
-             * will lose significant bits (or just result in 1)
-             * In this regime, the quadratic approximation, that is, the first
-             * two terms in the Taylor expansion, gives us a more accurate
-	     * value
-             */
-            log_b = -K * (prob_not_get_g_hit / log(2.0) + 
-	               prob_not_get_g_hit*prob_not_get_g_hit / (2*log(2.0)));
+/*
+ * This is a high precision evaluation of equation (1), for use as the
+ * reference that the faster evaluators are compared against.  It does
+ * everything in long double, computes 1 - prob_not_get_g_hit via
+ * expm1/log1p (so there's no need for the Taylor approximation), and only
+ * stops once the remaining terms can't affect the sum at long double
+ * precision.  It is far too slow to use in the search itself
+ */
+double compute_sec_level_reference( double m, int H, int T, int K ) {
+    long double log_lambda = (long double)m - H;
+    long double lambda = exp2l( log_lambda );
+    long double ln_single_miss = log1pl( -ldexpl( 1.0L, -T ) ); /* ln of */
+                    /* the probability a probe misses a specific signature */
+    long double log_sum = -INFINITY;  /* log2 of the running sum */
+    long double log_a = 0.0L;         /* log2 of lambda^g / g! */
+    unsigned g;
+
+    for (g = 1;; g++) {
+        log_a += log_lambda - log2l( g );
+
+        /* log2 of ( 1 - (1-2^-T)^g ) ^ K */
+        long double log_b = K * log2l( -expm1l( g * ln_single_miss ) );
+
+        long double term = log_a + log_b;
+        if (term > log_sum) {
+            log_sum = term + log2l( 1 + exp2l( log_sum - term ) );
         } else {
-            /*
-             * prob_not_get_g_hit is still large enough; compute it directly
-             */
-            log_b = K * log2( 1 - prob_not_get_g_hit );
+            log_sum = log_sum + log2l( 1 + exp2l( term - log_sum ) );
         }
 
-        /*
-         * Hence, the probability that this iteration adds to the sum is
-         * a*b, and since we're dealing with logs, log(ab) = log(a) + log(b)
-         */
+        /* Once we're past the peak of the Poisson terms, the rest of the */
+        /* sum is bounded by a geometric series; stop when that is lost in */
+        /* the rounding */
+        if (g > 2*lambda && log_sum > 80 + log_a) break;
+    }
+
+    return (double)(lambda / logl( 2.0L ) - log_sum);
+}
+
+/*
+ * This computes the security level after pow(2,m) signatures when the FORS
+ * trees aren't all the same height: K_tall of the K trees are T+1 high, and
+ * the rest are T high.  A forgery query still has to land on revealed
+ * leaves in every tree, so where equation (1) has K copies of the same
+ * log_b term, here we add up one term per tree height (with the same
+ * Taylor approximation as the kernels when the miss probability is small)
+ * The search doesn't evaluate these often enough to be worth a vector
+ * version; with K_tall == 0, we just hand it to compute_sec_level
+ */
+double compute_sec_level_mixed( double m, int H, int T, int K, int K_tall ) {
+    if (K_tall == 0) return compute_sec_level( m, H, T, K );
+
+    double log_lambda = m - H;
+    double lambda = pow( 2, log_lambda );
+    int count[2] = { K - K_tall, K_tall };  /* Trees of height T, T+1 */
+    double prob_not_get_single_hit[2] = { 1.0 - pow(0.5, T),
+                                          1.0 - pow(0.5, T+1) };
+    double prob_not_get_g_hit[2] = { 1.0, 1.0 };
+    double log_a = 0.0, log_sum = 0.0;
+
+    for (unsigned g = 1;; g++) {
+        log_a += log_lambda - log2(g);
+
+        double log_b = 0.0;
+        int i;
+        for (i = 0; i < 2; i++) {
+            double p = prob_not_get_g_hit[i] *= prob_not_get_single_hit[i];
+            if (p < 1E-5) {
+                log_b -= count[i] * (p / log(2.0) + p*p / (2*log(2.0)));
+            } else {
+                log_b += count[i] * log2( 1 - p );
+            }
+        }
 
         if (g == 1) {
-            /* For the first iteration, the running sum is the first output */
             log_sum = log_a+log_b;
         } else {
-            /* For latter iterations, add log(ab) to the running sum */
-            log_sum = do_add(log_sum, log_a+log_b);
+            log_sum = do_add_scalar(log_sum, log_a+log_b);
         }
-
-        /* Check for negative results (we don't meet the target) */
-        if (log_sum > log_target) return 0;  /* Sum exceeded target; we */
-                                      /* didn't meet the security level */
-
-        /* Check for positive results (we know we meet the target) */
-        if (g > 2*lambda) {
-            double p = lambda / (g+1);
-            double log_max_sum = log2(p) - log2(1-p); /* The maximum value */
-                                     /* the rest of the terms can add to sum */
-            if (do_add(log_sum, log_max_sum) <= log_target) return 1; /* The */
-                                     /* sum cannot reach target (that is, we */
-                                     /* will exceed the security level) */
-        }
-        if (g >= 10 && log_sum > 20 + log_a ) return 1; /* The rest of the */
-                                     /* terms are small; we will exceed the */
-                                     /* security level */
+        if (g >= 10 && log_sum > 20 + log_a ) break;
     }
+
+    return lambda * log2( exp( 1 )) - log_sum;
+}
+
+/*
+ * This is check_sec_level for the mixed height FORS trees
+ */
+int check_sec_level_mixed( double m, int H, int T, int K, int K_tall,
+                           double sec_level ) {
+    if (K_tall == 0) return check_sec_level( m, H, T, K, sec_level );
+    return compute_sec_level_mixed( m, H, T, K, K_tall ) >= sec_level;
 }
 
 /*
@@ -285,11 +594,19 @@ int check_sec_level( double m, int H, int T, int K, double sec_level ) {
  * (and stupid) way is good enough
  */
 int compute_sigs_at_sec_level( double sec_level, int H, int T, int K ) {
+    return compute_sigs_at_sec_level_mixed( sec_level, H, T, K, 0 );
+}
+
+/*
+ * The same, when K_tall of the K FORS trees are T+1 high
+ */
+int compute_sigs_at_sec_level_mixed( double sec_level, int H, int T, int K,
+                                     int K_tall ) {
     int lower;
 
     /* Scan for the number of signatures at a gross level (by integers) */
     for (lower = 0;; lower++) {
-        double r = compute_sec_level(lower + 1, H, T, K);
+        double r = compute_sec_level_mixed(lower + 1, H, T, K, K_tall);
         if (r < sec_level) break;
     }
     /* Ok, the nmber of signatures is between lower and lower+1, now scan */
@@ -297,7 +614,7 @@ int compute_sigs_at_sec_level( double sec_level, int H, int T, int K ) {
     int fract;
     for (fract = 0; fract < 100; fract++) {
         double m = lower + fract * 0.01 + 0.005;
-        double r = compute_sec_level(m, H, T, K);
+        double r = compute_sec_level_mixed(m, H, T, K, K_tall);
         if (r < sec_level) break;
     }
 
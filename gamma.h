@@ -1,3 +1,23 @@
 double compute_sec_level( double m, int H, int T, int K );
 int check_sec_level( double m, int H, int T, int K, double sec_level );
+void check_sec_level_batch( double m, int H, int T, int k_first, int count,
+                            double sec_level, unsigned char *ok );
 int compute_sigs_at_sec_level( double sec_level, int H, int T, int K );
+double compute_sec_level_mixed( double m, int H, int T, int K, int K_tall );
+int check_sec_level_mixed( double m, int H, int T, int K, int K_tall,
+                           double sec_level );
+int compute_sigs_at_sec_level_mixed( double sec_level, int H, int T, int K,
+                                     int K_tall );
+int gamma_select_isa( const char *name );
+const char *gamma_isa_name( void );
+void gamma_calibrate( const char *filename );
+int gamma_num_evaluators( void );
+const char *gamma_evaluator_name( int e );
+int gamma_evaluator_supported( int e );
+double gamma_evaluate( int e, double m, int H, int T, int K );
+int gamma_evaluate_check( int e, double m, int H, int T, int K,
+                          double sec_level );
+int gamma_evaluate_check_batch( int e, double m, int H, int T, int k_first,
+                                int count, double sec_level,
+                                unsigned char *ok );
+double compute_sec_level_reference( double m, int H, int T, int K );
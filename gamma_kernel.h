@@ -0,0 +1,323 @@
+/*
+ * This is the program that lists the potential Sphincs+ parameter sets,
+ * given the target requirements (security level, number of signatures at
+ * that security level, overuse characteristics)
+ *
+ * This file holds the security level kernels themselves.  It is not compiled
+ * on its own; gamma.c includes it once per instruction set it supports, with
+ * KERNEL(name) defined to give each copy its own names (and with the
+ * compiler target set to the instruction set for that copy)
+ *
+ * These keep most things in logarithmic form, that is, log_2 of the 'actual'
+ * value - this avoids overflows (and at the one point where we might lose
+ * significance, we have explicit code handling that)
+ */
+
+/* Add two values in log2 representation */
+/* That is, given log2(a), log2(b), this returns log2(a+b) */
+static double KERNEL(do_add)(double x, double y) {
+    double big, little;
+    if (x > y) {
+        big = x; little = y;
+    } else {
+        big = y; little = x;
+    }
+    if (big > little + 64) return big;  /* If a > b * 2^64, then log2(a+b) */
+                                        /* is essentially log2(a) */
+
+    double temp = 1 + pow( 0.5, big - little ); /* temp = 1 + b/a (assuming */
+                                        /* a >= b, otherwise swap them) */
+
+    return big + log2( temp );  /* big+log2(temp) = log(a) + log2(1 + b/a) */
+                                /*                = log( a*(1+b/a) ) */
+                                /* (assuming a >= b, otherwise swap them) */
+}
+
+/*
+ * This computes the security level after pow(2,m) signatures, assuming
+ * the hypertree has H levels, and that we have K FORS trees of height T
+ */
+static double KERNEL(compute_sec_level)( double m, int H, int T, int K ) {
+    /*
+     * Compute lambda which is the expected number of signatures per hypertree
+     * leaf at the specified number of signatures
+     */
+    double lambda;
+    if (m > H) {
+        lambda = pow(2, m-H);
+    } else {
+        lambda = pow(0.5, H-m);
+    }
+    double log_lambda = log2(lambda);   /* ... or m-H */
+
+    double prob_not_get_single_hit = 1.0 - pow(0.5, T); /* This is */
+        /* the probability that a probe does not hit a specific valid */
+        /* signature within a specific FORS tree */
+    double prob_not_get_g_hit = 1.0;  /* This is the probability that */
+        /* no probes hit a specific valid signature in a specific FORS tree */
+        /* after g signatures have been generated from this FORS */
+        /* This is updated as g is iterated */
+
+    double log_a = 0.0;    /* a == lambda^g */
+    double log_sum = 0.0;  /* the running sum */
+
+    for (unsigned g = 1;; g++) {
+            /* Update the variables that depend on g */
+        log_a += log_lambda;
+        log_a -= log2(g);
+        prob_not_get_g_hit *= prob_not_get_single_hit;
+
+        /*
+         * a is the probability that there will be precisely g valid signatures
+         * for this FORS (except for the constant e^{-\lambda} term; we'll
+         * account for that at the end)
+         */
+        
+        /*
+         * Compute b which is probability that a single forgery query will lie
+         * entirely in revealed FORS leaves (and thus will allow a signature
+         * of that forgery), assuming we have precisely g valid signatures for
+         * this FORS
+         */
+        double log_b;
+        if (prob_not_get_g_hit < 1E-5) {
+            /*
+             * If prob_not_get_g_hit is sufficiently small, the subtraction
+             * will lose significant bits (or just result in 1)
+             * In this regime, the quadratic approximation, that is, the first
+             * two terms in the Taylor expansion, gives us a more accurate
+	     * value
+             */
+            log_b = -K * (prob_not_get_g_hit / log(2.0) + 
+	               prob_not_get_g_hit*prob_not_get_g_hit / (2*log(2.0)));
+        } else {
+            /*
+             * prob_not_get_g_hit is still large enough; compute it directly
+             */
+            log_b = K * log2( 1 - prob_not_get_g_hit );
+        }
+
+        /*
+         * Hence, the probability that this iteration adds to the sum is
+         * a*b, and since we're dealing with logs, log(ab) = log(a) + log(b)
+         */
+
+        if (g == 1) {
+            /* For the first iteration, the running sum is the first output */
+            log_sum = log_a+log_b;
+        } else {
+            /* For latter iterations, add log(ab) to the running sum */
+            log_sum = KERNEL(do_add)(log_sum, log_a+log_b);
+        }
+
+        /*
+         * If the additional terms we're seeing is less than 2^{-20} of the
+         * sum, any further terms won't change the answer much - we might as
+         * well stop.  We test against log_a, as that is strictly decreasing
+         * and bounds the probability (as log_b < 0)
+         */
+        if (g >= 10 && log_sum > 20 + log_a ) break;
+    }
+
+    /*
+     * Return the -log2 of the total probability, that is, the expected
+     * security level.  And, since we didn't include the e^{-\lambda} constant
+     * term in 'a', we add it in now
+     */
+    return lambda * log2( exp( 1 )) - log_sum;
+}
+
+/*
+ * This does a quick test of whether, after pow(2,m) signatures, the
+ * specified Sphincs+ structure will meet the specified security level
+ * It does early outs (either way) when it is clear what the answer is, hence
+ * it is cheaper than computing the exact security level
+ */
+static int KERNEL(check_sec_level)( double m, int H, int T, int K,
+                                    double sec_level ) {
+    /*
+     * Compute lambda which is the expected number of signatures per hypertree
+     * leaf at the specified number of signatures
+     */
+    double lambda;
+    if (m > H) {
+        lambda = pow(2, m-H);
+    } else {
+        lambda = pow(0.5, H-m);
+    }
+    double log_lambda = log2(lambda);   /* ... or m-H */
+    double log_target = lambda * log2(exp(1)) - sec_level;  /* If log_sum */
+               /* exeeds this, we know we didn't hit the security level */
+
+    double prob_not_get_single_hit = 1.0 - pow(0.5, T); /* This is */
+        /* the probability that a probe does not hit a specific valid */
+        /* signature within a specific FORS tree */
+    double prob_not_get_g_hit = 1.0;  /* This is the probability that */
+        /* no probes hit a specific valid signature in a specific FORS tree */
+        /* after g signatures have been generated from this FORS */
+        /* This is updated as g is iterated */
+
+    double log_a = 0.0;    /* a == lambda^g */
+    double log_sum = 0.0;  /* the running sum */
+
+    for (unsigned g = 1;; g++) {
+            /* Update the variables that depend on g */
+        log_a += log_lambda;
+        log_a -= log2(g);
+        prob_not_get_g_hit *= prob_not_get_single_hit;
+
+        /*
+         * a is the probability that there will be precisely g valid signatures
+         * for this FORS (except for the constant e^{-\lambda} term; we'll
+         * account for that at the end)
+         */
+        
+        /*
+         * Compute b which is probability that a single forgery query will lie
+         * entirely in revealed FORS leaves (and thus will allow a signature
+         * of that forgery), assuming we have precisely g valid signatures for
+         * this FORS
+         */
+        double log_b;
+        if (prob_not_get_g_hit < 1E-5) {
+            /*
+             * If prob_not_get_g_hit is sufficiently small, the subtraction
+             * will lose significant bits (or just result in 1)
+             * In this regime, the quadratic approximation, that is, the first
+             * two terms in the Taylor expansion, gives us a more accurate
+	     * value
+             */
+            log_b = -K * (prob_not_get_g_hit / log(2.0) + 
+	               prob_not_get_g_hit*prob_not_get_g_hit / (2*log(2.0)));
+        } else {
+            /*
+             * prob_not_get_g_hit is still large enough; compute it directly
+             */
+            log_b = K * log2( 1 - prob_not_get_g_hit );
+        }
+
+        /*
+         * Hence, the probability that this iteration adds to the sum is
+         * a*b, and since we're dealing with logs, log(ab) = log(a) + log(b)
+         */
+
+        if (g == 1) {
+            /* For the first iteration, the running sum is the first output */
+            log_sum = log_a+log_b;
+        } else {
+            /* For latter iterations, add log(ab) to the running sum */
+            log_sum = KERNEL(do_add)(log_sum, log_a+log_b);
+        }
+
+        /* Check for negative results (we don't meet the target) */
+        if (log_sum > log_target) return 0;  /* Sum exceeded target; we */
+                                      /* didn't meet the security level */
+
+        /* Check for positive results (we know we meet the target) */
+        if (g > 2*lambda) {
+            double p = lambda / (g+1);
+            double log_max_sum = log_a + log2(p) - log2(1-p); /* The */
+                                     /* maximum value the rest of the terms */
+                                     /* can add to sum: each later a is at */
+                                     /* most p times the previous one, and */
+                                     /* b <= 1 */
+            if (KERNEL(do_add)(log_sum, log_max_sum) <= log_target) return 1; /* The */
+                                     /* sum cannot reach target (that is, we */
+                                     /* will exceed the security level) */
+        }
+        if (g >= 10 && log_sum > 20 + log_a ) return 1; /* The rest of the */
+                                     /* terms are small; we will exceed the */
+                                     /* security level */
+    }
+}
+
+/*
+ * This is check_sec_level for a run of consecutive FORS tree counts, that is,
+ * for K = k_first, k_first+1, ..., k_first+count-1 (with the other parameters
+ * the same).  ok[i] is set to the check_sec_level result for K = k_first+i
+ *
+ * The search asks about all these K values in a row; doing them together
+ * means that we compute everything that doesn't depend on K (log_a, the
+ * hit probabilities, the early out bounds) once per g, rather than once
+ * per g per K.  The per-K arithmetic is precisely what check_sec_level does,
+ * and so the answers are identical
+ */
+static void KERNEL(check_sec_level_batch)( double m, int H, int T,
+                                  int k_first, int count, double sec_level,
+                                  unsigned char *ok ) {
+    double lambda;
+    if (m > H) {
+        lambda = pow(2, m-H);
+    } else {
+        lambda = pow(0.5, H-m);
+    }
+    double log_lambda = log2(lambda);
+    double log_target = lambda * log2(exp(1)) - sec_level;
+    double prob_not_get_single_hit = 1.0 - pow(0.5, T);
+
+    while (count > 0) {
+        int n = count < BATCH_MAX ? count : BATCH_MAX;
+        double log_sum[ BATCH_MAX ];
+        unsigned char active[ BATCH_MAX ];
+        int i, num_active = n;
+        for (i=0; i<n; i++) active[i] = 1;
+
+        double prob_not_get_g_hit = 1.0;
+        double log_a = 0.0;
+
+        for (unsigned g = 1; num_active > 0; g++) {
+            log_a += log_lambda;
+            log_a -= log2(g);
+            prob_not_get_g_hit *= prob_not_get_single_hit;
+
+            /* log_b is K times this (or -K times, in the Taylor regime) */
+            int taylor = (prob_not_get_g_hit < 1E-5);
+            double log_b_unit;
+            if (taylor) {
+                log_b_unit = (prob_not_get_g_hit / log(2.0) + 
+                       prob_not_get_g_hit*prob_not_get_g_hit / (2*log(2.0)));
+            } else {
+                log_b_unit = log2( 1 - prob_not_get_g_hit );
+            }
+
+            /* The bound on the remaining terms (if we're far enough out) */
+            int have_max_sum = (g > 2*lambda);
+            double log_max_sum = 0;
+            if (have_max_sum) {
+                double p = lambda / (g+1);
+                log_max_sum = log_a + log2(p) - log2(1-p);
+            }
+            int small_terms = (g >= 10);
+
+            for (i=0; i<n; i++) {
+                if (!active[i]) continue;
+                int K = k_first + i;
+                double log_b = taylor ? -K * log_b_unit : K * log_b_unit;
+
+                if (g == 1) {
+                    log_sum[i] = log_a+log_b;
+                } else {
+                    log_sum[i] = KERNEL(do_add)(log_sum[i], log_a+log_b);
+                }
+
+                /* Same early outs as check_sec_level, in the same order */
+                if (log_sum[i] > log_target) {
+                    ok[i] = 0;
+                } else if (have_max_sum &&
+                        KERNEL(do_add)(log_sum[i], log_max_sum) <= log_target) {
+                    ok[i] = 1;
+                } else if (small_terms && log_sum[i] > 20 + log_a) {
+                    ok[i] = 1;
+                } else {
+                    continue;
+                }
+                active[i] = 0;
+                num_active--;
+            }
+        }
+
+        k_first += n;
+        count -= n;
+        ok += n;
+    }
+}
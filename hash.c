@@ -0,0 +1,387 @@
+/*
+ * This is the program that lists the potential Sphincs+ parameter sets,
+ * given the target requirements (security level, number of signatures at
+ * that security level, overuse characteristics)
+ *
+ * This part of the program holds the hash function primitives; the SHA-256
+ * and SHA-512 compression functions, and the Keccak-f[1600] permutation.
+ * We use these to find out how fast this host actually does them (so we can
+ * convert hash counts into time).  They're portable C; they're not as fast
+ * as a hand tuned assembly version, but they're in the right ballpark
+ *
+ * We also have multi-buffer versions, which do several independent
+ * compressions (or permutations) at once, one per lane; that's how a signer
+ * that cares about speed does the hundreds of thousands of independent
+ * hashes in a signature.  Those are written as loops over the lanes, which
+ * the compiler turns into vector code, for each instruction set
+ */
+#include <string.h>
+#include "hash.h"
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint64_t sha512_k[80] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL,
+    0xe9b5dba58189dbbcULL, 0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+    0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL, 0xd807aa98a3030242ULL,
+    0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL,
+    0xc19bf174cf692694ULL, 0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+    0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL, 0x2de92c6f592b0275ULL,
+    0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL,
+    0xbf597fc7beef0ee4ULL, 0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+    0x06ca6351e003826fULL, 0x142929670a0e6e70ULL, 0x27b70a8546d22ffcULL,
+    0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL,
+    0x92722c851482353bULL, 0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+    0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL, 0xd192e819d6ef5218ULL,
+    0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL,
+    0x34b0bcb5e19b48a8ULL, 0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+    0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL, 0x748f82ee5defb2fcULL,
+    0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL,
+    0xc67178f2e372532bULL, 0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+    0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL, 0x06f067aa72176fbaULL,
+    0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL,
+    0x431d67c49c100d4cULL, 0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+    0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL,
+};
+
+static const uint64_t keccak_rc[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL,
+    0x8000000080008000ULL, 0x000000000000808bULL, 0x0000000080000001ULL,
+    0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008aULL,
+    0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL,
+    0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+    0x000000000000800aULL, 0x800000008000000aULL, 0x8000000080008081ULL,
+    0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL,
+};
+
+/* The rho rotations and pi destinations, in the order pi visits the lanes */
+static const int keccak_rho[24] = {
+     1,  3,  6, 10, 15, 21, 28, 36, 45, 55,  2, 14,
+    27, 41, 56,  8, 25, 43, 62, 18, 39, 61, 20, 44,
+};
+static const int keccak_pi[24] = {
+    10,  7, 11, 17, 18,  3,  5, 16,  8, 21, 24,  4,
+    15, 23, 19, 13, 12,  2, 20, 14, 22,  9,  6,  1,
+};
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROR64(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+#define ROL64(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+static uint32_t load_be32( const unsigned char *p ) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint64_t load_be64( const unsigned char *p ) {
+    return ((uint64_t)load_be32( p ) << 32) | load_be32( p + 4 );
+}
+
+void sha256_compress( uint32_t state[8], const unsigned char block[64] ) {
+    uint32_t w[64];
+    int i;
+    for (i=0; i<16; i++) w[i] = load_be32( block + 4*i );
+    for (; i<64; i++) {
+        uint32_t s0 = ROR32(w[i-15], 7) ^ ROR32(w[i-15], 18) ^ (w[i-15] >> 3);
+        uint32_t s1 = ROR32(w[i-2], 17) ^ ROR32(w[i-2], 19) ^ (w[i-2] >> 10);
+        w[i] = w[i-16] + s0 + w[i-7] + s1;
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (i=0; i<64; i++) {
+        uint32_t t1 = h + (ROR32(e, 6) ^ ROR32(e, 11) ^ ROR32(e, 25)) +
+                      ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+        uint32_t t2 = (ROR32(a, 2) ^ ROR32(a, 13) ^ ROR32(a, 22)) +
+                      ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void sha512_compress( uint64_t state[8], const unsigned char block[128] ) {
+    uint64_t w[80];
+    int i;
+    for (i=0; i<16; i++) w[i] = load_be64( block + 8*i );
+    for (; i<80; i++) {
+        uint64_t s0 = ROR64(w[i-15], 1) ^ ROR64(w[i-15], 8) ^ (w[i-15] >> 7);
+        uint64_t s1 = ROR64(w[i-2], 19) ^ ROR64(w[i-2], 61) ^ (w[i-2] >> 6);
+        w[i] = w[i-16] + s0 + w[i-7] + s1;
+    }
+    uint64_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint64_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (i=0; i<80; i++) {
+        uint64_t t1 = h + (ROR64(e, 14) ^ ROR64(e, 18) ^ ROR64(e, 41)) +
+                      ((e & f) ^ (~e & g)) + sha512_k[i] + w[i];
+        uint64_t t2 = (ROR64(a, 28) ^ ROR64(a, 34) ^ ROR64(a, 39)) +
+                      ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void keccak_f1600( uint64_t state[25] ) {
+    uint64_t s[25];     /* Work on a local copy; once the loops are */
+                        /* unrolled, that can live in registers */
+    int round, i, j;
+    memcpy( s, state, sizeof s );
+    for (round = 0; round < 24; round++) {
+        uint64_t c[5], t;
+        /* theta */
+#pragma GCC unroll 5
+        for (i=0; i<5; i++) c[i] = s[i] ^ s[i+5] ^ s[i+10] ^ s[i+15] ^ s[i+20];
+#pragma GCC unroll 5
+        for (i=0; i<5; i++) {
+            t = c[(i+4)%5] ^ ROL64(c[(i+1)%5], 1);
+#pragma GCC unroll 5
+            for (j=0; j<25; j+=5) s[j+i] ^= t;
+        }
+        /* rho and pi */
+        t = s[1];
+#pragma GCC unroll 24
+        for (i=0; i<24; i++) {
+            uint64_t next = s[ keccak_pi[i] ];
+            s[ keccak_pi[i] ] = ROL64(t, keccak_rho[i]);
+            t = next;
+        }
+        /* chi */
+#pragma GCC unroll 5
+        for (j=0; j<25; j+=5) {
+#pragma GCC unroll 5
+            for (i=0; i<5; i++) c[i] = s[j+i];
+#pragma GCC unroll 5
+            for (i=0; i<5; i++) s[j+i] = c[i] ^ (~c[(i+1)%5] & c[(i+2)%5]);
+        }
+        /* iota */
+        s[0] ^= keccak_rc[round];
+    }
+    memcpy( state, s, sizeof s );
+}
+
+/*
+ * The multi-buffer versions; state[i][lane] is word i of that lane's state
+ */
+__attribute__((target_clones("avx512f", "avx2", "default")))
+void sha256_compress_mb( uint32_t state[8][SHA256_LANES],
+                         const unsigned char *block[SHA256_LANES] ) {
+    uint32_t w[64][SHA256_LANES];
+    uint32_t v[8][SHA256_LANES];
+    int i, l;
+    for (i=0; i<16; i++) {
+        for (l=0; l<SHA256_LANES; l++) w[i][l] = load_be32( block[l] + 4*i );
+    }
+    for (; i<64; i++) {
+        for (l=0; l<SHA256_LANES; l++) {
+            uint32_t x = w[i-15][l], y = w[i-2][l];
+            w[i][l] = w[i-16][l] + (ROR32(x, 7) ^ ROR32(x, 18) ^ (x >> 3)) +
+                      w[i-7][l] + (ROR32(y, 17) ^ ROR32(y, 19) ^ (y >> 10));
+        }
+    }
+    memcpy( v, state, sizeof v );
+    for (i=0; i<64; i++) {
+        for (l=0; l<SHA256_LANES; l++) {
+            uint32_t a = v[0][l], b = v[1][l], c = v[2][l], e = v[4][l];
+            uint32_t t1 = v[7][l] + (ROR32(e, 6) ^ ROR32(e, 11) ^ ROR32(e, 25)) +
+                          ((e & v[5][l]) ^ (~e & v[6][l])) + sha256_k[i] + w[i][l];
+            uint32_t t2 = (ROR32(a, 2) ^ ROR32(a, 13) ^ ROR32(a, 22)) +
+                          ((a & b) ^ (a & c) ^ (b & c));
+            v[7][l] = v[6][l]; v[6][l] = v[5][l]; v[5][l] = e;
+            v[4][l] = v[3][l] + t1;
+            v[3][l] = c; v[2][l] = b; v[1][l] = a; v[0][l] = t1 + t2;
+        }
+    }
+    for (i=0; i<8; i++) {
+        for (l=0; l<SHA256_LANES; l++) state[i][l] += v[i][l];
+    }
+}
+
+__attribute__((target_clones("avx512f", "avx2", "default")))
+void sha512_compress_mb( uint64_t state[8][SHA512_LANES],
+                         const unsigned char *block[SHA512_LANES] ) {
+    uint64_t w[80][SHA512_LANES];
+    uint64_t v[8][SHA512_LANES];
+    int i, l;
+    for (i=0; i<16; i++) {
+        for (l=0; l<SHA512_LANES; l++) w[i][l] = load_be64( block[l] + 8*i );
+    }
+    for (; i<80; i++) {
+        for (l=0; l<SHA512_LANES; l++) {
+            uint64_t x = w[i-15][l], y = w[i-2][l];
+            w[i][l] = w[i-16][l] + (ROR64(x, 1) ^ ROR64(x, 8) ^ (x >> 7)) +
+                      w[i-7][l] + (ROR64(y, 19) ^ ROR64(y, 61) ^ (y >> 6));
+        }
+    }
+    memcpy( v, state, sizeof v );
+    for (i=0; i<80; i++) {
+        for (l=0; l<SHA512_LANES; l++) {
+            uint64_t a = v[0][l], b = v[1][l], c = v[2][l], e = v[4][l];
+            uint64_t t1 = v[7][l] + (ROR64(e, 14) ^ ROR64(e, 18) ^ ROR64(e, 41)) +
+                          ((e & v[5][l]) ^ (~e & v[6][l])) + sha512_k[i] + w[i][l];
+            uint64_t t2 = (ROR64(a, 28) ^ ROR64(a, 34) ^ ROR64(a, 39)) +
+                          ((a & b) ^ (a & c) ^ (b & c));
+            v[7][l] = v[6][l]; v[6][l] = v[5][l]; v[5][l] = e;
+            v[4][l] = v[3][l] + t1;
+            v[3][l] = c; v[2][l] = b; v[1][l] = a; v[0][l] = t1 + t2;
+        }
+    }
+    for (i=0; i<8; i++) {
+        for (l=0; l<SHA512_LANES; l++) state[i][l] += v[i][l];
+    }
+}
+
+__attribute__((target_clones("avx512f", "avx2", "default")))
+void keccak_f1600_mb( uint64_t s[25][KECCAK_LANES] ) {
+    int round, i, j, l;
+    for (round = 0; round < 24; round++) {
+        uint64_t c[5][KECCAK_LANES], t[KECCAK_LANES];
+        for (i=0; i<5; i++) {
+            for (l=0; l<KECCAK_LANES; l++) {
+                c[i][l] = s[i][l] ^ s[i+5][l] ^ s[i+10][l] ^ s[i+15][l] ^ s[i+20][l];
+            }
+        }
+        for (i=0; i<5; i++) {
+            for (l=0; l<KECCAK_LANES; l++) {
+                t[l] = c[(i+4)%5][l] ^ ROL64(c[(i+1)%5][l], 1);
+            }
+            for (j=0; j<25; j+=5) {
+                for (l=0; l<KECCAK_LANES; l++) s[j+i][l] ^= t[l];
+            }
+        }
+        for (l=0; l<KECCAK_LANES; l++) t[l] = s[1][l];
+        for (i=0; i<24; i++) {
+            for (l=0; l<KECCAK_LANES; l++) {
+                uint64_t next = s[ keccak_pi[i] ][l];
+                s[ keccak_pi[i] ][l] = ROL64(t[l], keccak_rho[i]);
+                t[l] = next;
+            }
+        }
+        for (j=0; j<25; j+=5) {
+            for (i=0; i<5; i++) {
+                for (l=0; l<KECCAK_LANES; l++) c[i][l] = s[j+i][l];
+            }
+            for (i=0; i<5; i++) {
+                for (l=0; l<KECCAK_LANES; l++) {
+                    s[j+i][l] = c[i][l] ^ (~c[(i+1)%5][l] & c[(i+2)%5][l]);
+                }
+            }
+        }
+        for (l=0; l<KECCAK_LANES; l++) s[0][l] ^= keccak_rc[round];
+    }
+}
+
+/*
+ * Complete hashes, built on the above (for the SLH-DSA engine)
+ */
+static const uint32_t sha256_iv[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+static const uint64_t sha512_iv[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL,
+    0xa54ff53a5f1d36f1ULL, 0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL,
+};
+
+void sha256_init( uint32_t state[8] ) {
+    memcpy( state, sha256_iv, sizeof sha256_iv );
+}
+
+void sha512_init( uint64_t state[8] ) {
+    memcpy( state, sha512_iv, sizeof sha512_iv );
+}
+
+/*
+ * Finish a SHA-256 hash; state is the state after the first done bytes (a
+ * multiple of 64) were processed (which can be the IV, with done = 0), and
+ * in is the rest of the input.  Writes the 32 byte hash to out
+ */
+void sha256_tail( const uint32_t state[8], uint64_t done,
+                  const unsigned char *in, size_t len, unsigned char *out ) {
+    uint32_t s[8];
+    unsigned char block[128];
+    uint64_t bits = 8 * (done + len);
+    int i;
+    memcpy( s, state, sizeof s );
+    for (; len >= 64; in += 64, len -= 64) sha256_compress( s, in );
+    size_t pad = len < 56 ? 64 : 128;
+    memset( block, 0, pad );
+    memcpy( block, in, len );
+    block[len] = 0x80;
+    for (i=0; i<8; i++) block[pad-1-i] = bits >> (8*i);
+    sha256_compress( s, block );
+    if (pad == 128) sha256_compress( s, block + 64 );
+    for (i=0; i<32; i++) out[i] = s[i/4] >> (24 - 8*(i%4));
+}
+
+/*
+ * The same, for SHA-512 (done is a multiple of 128; out gets 64 bytes)
+ */
+void sha512_tail( const uint64_t state[8], uint64_t done,
+                  const unsigned char *in, size_t len, unsigned char *out ) {
+    uint64_t s[8];
+    unsigned char block[256];
+    uint64_t bits = 8 * (done + len);
+    int i;
+    memcpy( s, state, sizeof s );
+    for (; len >= 128; in += 128, len -= 128) sha512_compress( s, in );
+    size_t pad = len < 112 ? 128 : 256;
+    memset( block, 0, pad );
+    memcpy( block, in, len );
+    block[len] = 0x80;
+    for (i=0; i<8; i++) block[pad-1-i] = bits >> (8*i);
+    sha512_compress( s, block );
+    if (pad == 256) sha512_compress( s, block + 128 );
+    for (i=0; i<64; i++) out[i] = s[i/8] >> (56 - 8*(i%8));
+}
+
+/*
+ * SHAKE256; hash in, and write outlen bytes to out
+ */
+void shake256( unsigned char *out, size_t outlen,
+               const unsigned char *in, size_t inlen ) {
+    enum { RATE = 136 };
+    uint64_t s[25] = { 0 };
+    size_t i;
+    for (;;) {
+        size_t take = inlen < RATE ? inlen : RATE;
+        for (i=0; i<take; i++) s[i/8] ^= (uint64_t)in[i] << (8*(i%8));
+        if (take < RATE) {
+            /* Last block; add the padding (0x1f ... 0x80) */
+            s[take/8] ^= (uint64_t)0x1f << (8*(take%8));
+            s[(RATE-1)/8] ^= (uint64_t)0x80 << (8*((RATE-1)%8));
+            keccak_f1600( s );
+            break;
+        }
+        keccak_f1600( s );
+        in += RATE; inlen -= RATE;
+    }
+    for (;;) {
+        size_t give = outlen < RATE ? outlen : RATE;
+        for (i=0; i<give; i++) out[i] = s[i/8] >> (8*(i%8));
+        if (give == outlen) break;
+        out += RATE; outlen -= RATE;
+        keccak_f1600( s );
+    }
+}
@@ -0,0 +1,28 @@
+#include <stddef.h>
+#include <stdint.h>
+
+void sha256_compress( uint32_t state[8], const unsigned char block[64] );
+void sha512_compress( uint64_t state[8], const unsigned char block[128] );
+void keccak_f1600( uint64_t state[25] );
+
+/*
+ * The multi-buffer versions; these do one compression (or permutation) in
+ * each lane, with state[i][lane] being word i of the state of that lane
+ */
+#define SHA256_LANES 8
+#define SHA512_LANES 4
+#define KECCAK_LANES 4
+void sha256_compress_mb( uint32_t state[8][SHA256_LANES],
+                         const unsigned char *block[SHA256_LANES] );
+void sha512_compress_mb( uint64_t state[8][SHA512_LANES],
+                         const unsigned char *block[SHA512_LANES] );
+void keccak_f1600_mb( uint64_t state[25][KECCAK_LANES] );
+
+void sha256_init( uint32_t state[8] );
+void sha512_init( uint64_t state[8] );
+void sha256_tail( const uint32_t state[8], uint64_t done,
+                  const unsigned char *in, size_t len, unsigned char *out );
+void sha512_tail( const uint64_t state[8], uint64_t done,
+                  const unsigned char *in, size_t len, unsigned char *out );
+void shake256( unsigned char *out, size_t outlen,
+               const unsigned char *in, size_t inlen );
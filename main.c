@@ -8,7 +8,15 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
 #include "search.h"
+#include "gamma.h"
+#include "validate.h"
+#include "simulate.h"
+#include "curves.h"
+#include "query.h"
+#include "cost.h"
 
 /*
  * Routine used to parse parameters in the form XXX=<number>
@@ -35,6 +43,39 @@ static unsigned long get_int_param( const char *arg, const char *param_name ) {
     return val;
 }
 
+/*
+ * Routine used to parse parameters in the form XXX=<decimal number>
+ * It returns either 0 (parameter wasn't of that form, or the number isn't
+ * positive) or the value of <number>
+ */
+static double get_double_param( const char *arg, const char *param_name ) {
+    size_t len = strlen( param_name );
+    if (0 != strncmp( arg, param_name, len )) return 0;
+    arg += len;
+    if (!isdigit( *arg ) && *arg != '.') return 0;
+
+    char *end;
+    double val = strtod( arg, &end );
+    if (*end != '\0') return 0;  /* Oops; not expecting anything after */
+                                 /* the number */
+    return val > 0 ? val : 0;
+}
+
+/*
+ * Get a weight for objective=weighted; unlike get_double_param, 0 is a
+ * fine value, so this returns -1 if it isn't a number, or is negative
+ */
+static double get_weight_param( const char *arg, const char *param_name ) {
+    size_t len = strlen( param_name );
+    if (0 != strncmp( arg, param_name, len )) return -1;
+    arg += len;
+
+    char *end;
+    double val = strtod( arg, &end );
+    if (end == arg || *end != '\0') return -1;
+    return val >= 0 ? val : -1;
+}
+
 static void usage(const char *program) {
     fprintf( stderr, "Usage: %s params\n", program );
     fprintf( stderr, "Supported parameters:\n"
@@ -44,13 +85,83 @@ static void usage(const char *program) {
                      "           This is the log2; 16 means 65536 signatures\n"
                      "    sign=# Maximum number of hashes during signing\n"
                      "           Must be specified\n"
+                     "    maxsig=# Maximum signature size, in bytes\n"
+                     "    maxver=# Maximum number of hashes to verify\n"
+                     "    keygen=# Maximum number of hashes during key generation (also\n"
+                     "           lists that cost)\n"
+                     "    mem=#  Maximum memory (in bytes) the signer can use (also lists\n"
+                     "           that)\n"
+                     "    hash=sha2|shake Count the sign and verify costs (and sign=) in\n"
+                     "           SHA-2 compression calls or Keccak permutations,\n"
+                     "           rather than in hashes\n"
+                     "    predict=1 Time the hash primitives on this host, and list the\n"
+                     "           predicted sign and verify times\n"
+                     "    signus=# Maximum predicted signing time, in microseconds (can\n"
+                     "           be given instead of sign=)\n"
+                     "    bench=# Sign and verify with the first # parameter sets listed,\n"
+                     "           using the built-in SLH-DSA, and compare the times\n"
+                     "           with the predicted ones\n"
+                     "    lanes=# List the sign and verify costs of a signer that does #\n"
+                     "           hashes at once (multi-buffer)\n"
+                     "    cores=# List the sign latency when the Merkle and FORS trees are\n"
+                     "           built on # cores\n"
+                     "    cache=# List the amortized sign cost when the top hypertree\n"
+                     "           layers that fit in # MB are cached\n"
+                     "    budget=serial|lanes|cores|cached Which sign cost sign= limits, and\n"
+                     "           equal sized parameter sets are ranked by (default serial)\n"
+                     "    objective=size|weighted List the parameter sets in order of signature\n"
+                     "           size (default), or of wbyte*size + wsign*sign cost +\n"
+                     "           wver*verify cost\n"
+                     "    wbyte=# wsign=# wver=# The weights for objective=weighted\n"
+                     "    rank=size|sign|verify List the parameter sets in order of the\n"
+                     "           objective (default), or of the sign or verify cost\n"
+                     "    pareto=1 List every parameter set which none beats in size, sign\n"
+                     "           cost, verify cost and overuse\n"
+                     "    mixed=1 Let the Merkle trees differ in height (these aren't\n"
+                     "           FIPS 205 parameter sets)\n"
+                     "    forsmix=1 Let some of the FORS trees be one taller than the\n"
+                     "           rest (nor are these)\n"
+                     "    stats=1 Report how many security level evaluations the search\n"
+                     "           made, and how many it avoided\n"
                      "    tests=# The test security level for overuse\n"
                      "    maxs=# Stop listing parameter sets once they hit\n"
                      "           log2 number of signatures for overuse security\n"
                      "    label=string Prefix each entry with the given label\n"
+                     "    format=latex|jsonl How to list the parameter sets; as a Latex\n"
+                     "           table (default), or as one JSON object per line\n"
+                     "    curves=file Write the overuse curves into this one binary file,\n"
+                     "           rather than into CSV files\n"
+                     "    curvetol=# Sample the overuse curves adaptively, to within this\n"
+                     "           many bits (rather than every 0.01)\n"
+                     "    curvepts=# The most points in an adaptively sampled curve\n"
+                     "    dump=file Also write every acceptable parameter set found (not\n"
+                     "           just the listed ones) into this binary file\n"
+                     "    query=file Instead of searching, list the parameter sets in a\n"
+                     "           dump= file that match where=, in order of sort=\n"
+                     "    where=conditions For query=, e.g. sig_size<8000,sig_time<2^20,w=16\n"
+                     "    sort=field For query=, the field to list in order of (default\n"
+                     "           sig_size)\n"
+                     "    top=#  List only the best # parameter sets (also for query=)\n"
+                     "    tocsv=file Instead of searching, convert a curves= file into the\n"
+                     "           CSV files we'd have written without it\n"
                      "    d=#    Only consider parameter sets with the specified tree depth\n"
                      "    h=#    Only consider parameter sets with the specified merkle height\n"
                      "    a=#    Only consider parameter sets with the specified number of FORS\n"
+                     "    isa=name Use the given security level kernels (auto, scalar,\n"
+                     "           avx2, avx512); default is the best one the CPU supports\n"
+                     "    calibrate=1 Time the security level evaluators at startup, and\n"
+                     "           use the fastest one for each regime\n"
+                     "    calib=file Same, but keep the calibration in the given file\n"
+                     "           (and reuse it if it is already there)\n"
+                     "    validate=# Instead of searching, compare the security level\n"
+                     "           evaluators against the reference on this many samples\n"
+                     "    soak=1 Same, but keep going until killed\n"
+                     "    simulate=# Instead of searching, run a Monte Carlo simulation of\n"
+                     "           the parameter set given by d=, h=, a= and k=, after 2^n\n"
+                     "           (up to 2^maxs) signatures, with this many trials each\n"
+                     "    k=#    Number of FORS trees (for simulate=)\n"
+                     "    threads=# Number of threads to validate or simulate with\n"
+                     "           (default: one per CPU)\n"
             );                 
 }
 
@@ -62,6 +173,13 @@ int main(int argc, char **argv) {
     int sec_level = 0;
     int num_sig = 0;
     int sign_op = 0;
+    unsigned keygen_op = 0;
+    unsigned mem_bytes = 0;
+    unsigned max_sig = 0;
+    unsigned max_ver = 0;
+    int mixed = 0;
+    int forsmix = 0;
+    int stats = 0;
     int test_s = 0;
     int max_s = 0;
     int d = 0;
@@ -69,6 +187,36 @@ int main(int argc, char **argv) {
     int a = 0;
     int i;
     char *label = 0;
+    int format = FORMAT_LATEX;
+    char *curves_file = 0;
+    char *tocsv_file = 0;
+    char *dump_file = 0;
+    int hash = HASH_ABSTRACT;
+    int predict = 0;
+    double sign_us = 0;
+    int bench = 0;
+    unsigned lanes = 0;
+    unsigned cores = 0;
+    double cache_mb = 0;
+    int objective = OBJECTIVE_SIZE;
+    double w_byte = 0, w_sign = 0, w_ver = 0;
+    int rank = RANK_SIZE;
+    int pareto = 0;
+    int budget = BUDGET_SERIAL;
+    char *query_file = 0;
+    char *where = 0;
+    char *sort = 0;
+    unsigned long top = 0;
+    double curve_tol = 0;
+    int curve_pts = 0;
+    int isa_given = 0;
+    int calibrate = 0;
+    char *calib_file = 0;
+    unsigned long validate = 0;
+    int soak = 0;
+    int threads = 0;
+    unsigned long simulate = 0;
+    int k = 0;
 
     /* Parse the parameters */
     for (i=1; i<argc; i++) {
@@ -85,6 +233,61 @@ int main(int argc, char **argv) {
         else if ((t = get_int_param( argv[i], "sign=" )) != 0) {
             sign_op = t;
         }
+        /* Check for the number of hash operations during key generation */
+        else if ((t = get_int_param( argv[i], "keygen=" )) != 0) {
+            keygen_op = t;
+        }
+        /* Check for the signature size limit */
+        else if ((t = get_int_param( argv[i], "maxsig=" )) != 0) {
+            max_sig = t;
+        }
+        /* Check for the verify limit */
+        else if ((t = get_int_param( argv[i], "maxver=" )) != 0) {
+            max_ver = t;
+        }
+        /* Check for mixed Merkle tree heights */
+        else if ((t = get_int_param( argv[i], "mixed=" )) != 0) {
+            mixed = 1;
+        }
+        /* ... and FORS tree heights */
+        else if ((t = get_int_param( argv[i], "forsmix=" )) != 0) {
+            forsmix = 1;
+        }
+        else if ((t = get_int_param( argv[i], "stats=" )) != 0) {
+            stats = 1;
+        }
+        /* Check for the signer memory limit */
+        else if ((t = get_int_param( argv[i], "mem=" )) != 0) {
+            mem_bytes = t;
+        }
+        /* Check for what we rank by */
+        else if (0 == strcmp( argv[i], "objective=size" )) {
+            objective = OBJECTIVE_SIZE;
+        }
+        else if (0 == strcmp( argv[i], "objective=weighted" )) {
+            objective = OBJECTIVE_WEIGHTED;
+        }
+        else if (0 == strncmp( argv[i], "wbyte=", 6 )) {
+            w_byte = get_weight_param( argv[i], "wbyte=" );
+        }
+        else if (0 == strncmp( argv[i], "wsign=", 6 )) {
+            w_sign = get_weight_param( argv[i], "wsign=" );
+        }
+        else if (0 == strncmp( argv[i], "wver=", 5 )) {
+            w_ver = get_weight_param( argv[i], "wver=" );
+        }
+        else if (0 == strcmp( argv[i], "rank=size" )) {
+            rank = RANK_SIZE;
+        }
+        else if (0 == strcmp( argv[i], "rank=sign" )) {
+            rank = RANK_SIGN;
+        }
+        else if (0 == strcmp( argv[i], "rank=verify" )) {
+            rank = RANK_VERIFY;
+        }
+        else if ((t = get_int_param( argv[i], "pareto=" )) != 0) {
+            pareto = 1;
+        }
         /* Check for the overuse test level */
         else if ((t = get_int_param( argv[i], "tests=" )) != 0) {
             test_s = t;
@@ -97,6 +300,99 @@ int main(int argc, char **argv) {
         else if (0 == strncmp( argv[i], "label=", 6 )) {
             label = &argv[i][6];
         }
+        /* Check for the output format */
+        else if (0 == strcmp( argv[i], "format=latex" )) {
+            format = FORMAT_LATEX;
+        }
+        else if (0 == strcmp( argv[i], "format=jsonl" )) {
+            format = FORMAT_JSONL;
+        }
+        /* Check for the curve store */
+        else if (0 == strncmp( argv[i], "curves=", 7 )) {
+            curves_file = &argv[i][7];
+        }
+        else if (0 == strncmp( argv[i], "curvetol=", 9 )) {
+            curve_tol = get_double_param( argv[i], "curvetol=" );
+            if (curve_tol == 0) {
+                usage(argv[0]);
+                return 0;
+            }
+        }
+        else if ((t = get_int_param( argv[i], "curvepts=" )) != 0) {
+            curve_pts = t;
+        }
+        /* Check for the hash function to cost things with */
+        else if (0 == strncmp( argv[i], "hash=", 5 )) {
+            hash = hash_lookup( &argv[i][5] );
+            if (hash < 0) {
+                usage(argv[0]);
+                return 0;
+            }
+        }
+        /* Check for time predictions */
+        else if ((t = get_int_param( argv[i], "predict=" )) != 0) {
+            predict = 1;
+        }
+        else if (0 == strncmp( argv[i], "signus=", 7 )) {
+            sign_us = get_double_param( argv[i], "signus=" );
+            if (sign_us == 0) {
+                usage(argv[0]);
+                return 0;
+            }
+            predict = 1;
+        }
+        else if ((t = get_int_param( argv[i], "bench=" )) != 0) {
+            bench = t;
+            predict = 1;
+        }
+        /* Check for the multi-buffer cost model */
+        else if ((t = get_int_param( argv[i], "lanes=" )) != 0) {
+            lanes = t;
+        }
+        /* Check for the multi-core cost model */
+        else if ((t = get_int_param( argv[i], "cores=" )) != 0) {
+            cores = t;
+        }
+        /* Check for the cached hypertree cost model */
+        else if (0 == strncmp( argv[i], "cache=", 6 )) {
+            cache_mb = get_double_param( argv[i], "cache=" );
+            if (cache_mb == 0) {
+                usage(argv[0]);
+                return 0;
+            }
+        }
+        else if (0 == strcmp( argv[i], "budget=serial" )) {
+            budget = BUDGET_SERIAL;
+        }
+        else if (0 == strcmp( argv[i], "budget=lanes" )) {
+            budget = BUDGET_LANES;
+        }
+        else if (0 == strcmp( argv[i], "budget=cores" )) {
+            budget = BUDGET_CORES;
+        }
+        else if (0 == strcmp( argv[i], "budget=cached" )) {
+            budget = BUDGET_CACHED;
+        }
+        /* Check for the candidate dump */
+        else if (0 == strncmp( argv[i], "dump=", 5 )) {
+            dump_file = &argv[i][5];
+        }
+        /* Check for query mode */
+        else if (0 == strncmp( argv[i], "query=", 6 )) {
+            query_file = &argv[i][6];
+        }
+        else if (0 == strncmp( argv[i], "where=", 6 )) {
+            where = &argv[i][6];
+        }
+        else if (0 == strncmp( argv[i], "sort=", 5 )) {
+            sort = &argv[i][5];
+        }
+        else if ((t = get_int_param( argv[i], "top=" )) != 0) {
+            top = t;
+        }
+        else if (0 == strncmp( argv[i], "tocsv=", 6 )) {
+            tocsv_file = &argv[i][6];
+        }
         /* Check for the d */
         else if ((t = get_int_param( argv[i], "d=" )) != 0) {
             d = t;
@@ -109,12 +405,75 @@ int main(int argc, char **argv) {
         else if ((t = get_int_param( argv[i], "a=" )) != 0) {
             a = t;
         }
+        /* Check for the kernel override */
+        else if (0 == strncmp( argv[i], "isa=", 4 )) {
+            if (!gamma_select_isa( &argv[i][4] )) {
+                fprintf( stderr, "kernel %s not supported on this CPU\n", &argv[i][4] );
+                return 0;
+            }
+            isa_given = 1;
+        }
+        /* Check for evaluator calibration */
+        else if ((t = get_int_param( argv[i], "calibrate=" )) != 0) {
+            calibrate = 1;
+        }
+        else if (0 == strncmp( argv[i], "calib=", 6 )) {
+            calib_file = &argv[i][6];
+        }
+        /* Check for validation mode */
+        else if ((t = get_int_param( argv[i], "validate=" )) != 0) {
+            validate = t;
+        }
+        else if ((t = get_int_param( argv[i], "soak=" )) != 0) {
+            soak = 1;
+        }
+        else if ((t = get_int_param( argv[i], "threads=" )) != 0) {
+            threads = t;
+        }
+        /* Check for simulation mode */
+        else if ((t = get_int_param( argv[i], "simulate=" )) != 0) {
+            simulate = t;
+        }
+        else if ((t = get_int_param( argv[i], "k=" )) != 0) {
+            k = t;
+        }
         else {
             usage(argv[0]);
             return 0;
         }
     }
 
+    /* Pick the security level evaluators (unless the user picked one) */
+    if ((calibrate || calib_file) && !isa_given) {
+        gamma_calibrate( calib_file );
+    }
+
+    /* If we were asked to convert a curve file, do that instead */
+    if (tocsv_file) {
+        return curves_to_csv( tocsv_file ) ? 0 : 1;
+    }
+
+    /* If we were asked to query a dump file, do that instead */
+    if (query_file) {
+        return run_query( query_file, where, sort, top, format ) ? 0 : 1;
+    }
+
+    /* If we were asked to validate the evaluators, do that instead */
+    if (validate || soak) {
+        return run_validation( soak ? 0 : validate, threads ) ? 1 : 0;
+    }
+
+    /* If we were asked to simulate a parameter set, do that instead */
+    if (simulate) {
+        if (!d || !h || !a || !k || !num_sig) {
+            fprintf( stderr, "simulate= needs d=, h=, a=, k= and n=\n" );
+            usage(argv[0]);
+            return 0;
+        }
+        run_simulation( d*h, a, k, num_sig, max_s, simulate, threads );
+        return 0;
+    }
+
     /* Check if all the mandatory parameters were provided */
     if (sec_level == 0) {
         fprintf( stderr, "security level not specified\n" );
@@ -126,12 +485,54 @@ int main(int argc, char **argv) {
         usage(argv[0]);
         return 0;
     }
-    if (sign_op == 0) {
+    if (sign_op == 0 && sign_us == 0) {
         fprintf( stderr, "max number of hashes per sign operation not specified\n" );
         usage(argv[0]);
         return 0;
     }
 
+    if (budget != BUDGET_SERIAL && sign_us != 0) {
+        fprintf( stderr, "signus= is a serial budget; it can't be used with budget=\n" );
+        usage(argv[0]);
+        return 0;
+    }
+    if (budget == BUDGET_LANES && lanes == 0) {
+        lanes = 8;      /* AVX2 SHA-256 */
+    }
+    if (w_byte < 0 || w_sign < 0 || w_ver < 0) {
+        /* (a negative weight would rank the bigger or slower sets first) */
+        fprintf( stderr, "wbyte=, wsign= and wver= must be numbers, and "
+                         "can't be negative\n" );
+        usage(argv[0]);
+        return 0;
+    }
+    if (objective == OBJECTIVE_WEIGHTED && !w_byte && !w_sign && !w_ver) {
+        fprintf( stderr, "objective=weighted needs wbyte=, wsign= or wver=\n" );
+        usage(argv[0]);
+        return 0;
+    }
+    if (budget == BUDGET_CACHED && cache_mb == 0) {
+        fprintf( stderr, "budget=cached needs cache=\n" );
+        usage(argv[0]);
+        return 0;
+    }
+    if (mixed && (dump_file || bench)) {
+        fprintf( stderr, "mixed=1 can't be used with dump= or bench= (they "
+                         "need the same height Merkle trees)\n" );
+        usage(argv[0]);
+        return 0;
+    }
+    if (forsmix && (dump_file || bench)) {
+        fprintf( stderr, "forsmix=1 can't be used with dump= or bench= (they "
+                         "need the same height FORS trees)\n" );
+        usage(argv[0]);
+        return 0;
+    }
+    if (budget == BUDGET_CORES && cores == 0) {
+        long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+        cores = cpus > 0 ? cpus : 1;
+    }
+
     /* If the secondary security level (for overuse) was not provided, pick */
     /* a reasonable default */
     if (test_s == 0) {
@@ -140,7 +541,47 @@ int main(int argc, char **argv) {
     }
 
     /* Pass the parameters to the searcher */
-    do_search( sec_level, num_sig, test_s, sign_op, max_s, label, d, h, a );
+    struct search_params params = { 0 };
+    params.sec_level = sec_level;
+    params.num_sig = num_sig;
+    params.test_sec_level = test_s;
+    params.sign_op = sign_op;
+    params.max_s = max_s;
+    params.keygen_op = keygen_op;
+    params.mem_bytes = mem_bytes;
+    params.label = label;
+    params.d_restrict = d;
+    params.h_restrict = h;
+    params.a_restrict = a;
+    params.format = format;
+    params.curves_file = curves_file;
+    params.curve_tol = curve_tol;
+    params.curve_pts = curve_pts;
+    params.dump_file = dump_file;
+    params.hash = hash;
+    params.predict = predict;
+    params.sign_us = sign_us;
+    params.bench = bench;
+    params.lanes = lanes;
+    params.cores = cores;
+    params.cache_mb = cache_mb;
+    params.budget = budget;
+    params.objective = objective;
+    params.w_byte = w_byte;
+    params.w_sign = w_sign;
+    params.w_ver = w_ver;
+    params.rank = rank;
+    params.pareto = pareto;
+    params.top = top;
+    params.max_sig = max_sig;
+    params.max_ver = max_ver;
+    params.mixed = mixed;
+    params.forsmix = forsmix;
+    params.stats = stats;
+    if (predict) {
+        calibrate_host();
+    }
+    do_search( &params );
 
     return 0;
 }
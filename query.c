@@ -0,0 +1,480 @@
+/*
+ * This is the program that lists the potential Sphincs+ parameter sets,
+ * given the target requirements (security level, number of signatures at
+ * that security level, overuse characteristics)
+ *
+ * This part of the program answers queries over a dump= file; for example,
+ * "all the parameter sets with a signature size below 8000, sign time below
+ * 2^20, and w=16, in order of verify time".  Rerunning the search with
+ * different filters takes minutes; this takes milliseconds.
+ *
+ * We do that by keeping sorted indexes on the interesting fields (in a file
+ * next to the dump; see dump.h).  To answer a query, we look at how many
+ * records each index says are in range, and scan the smallest such range
+ * (checking the rest of the conditions as we go).  If the sort order is one
+ * of the indexed fields, we may instead walk that index in order, which
+ * means we can stop as soon as we've found enough
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "query.h"
+#include "dump.h"
+#include "writer.h"
+#include "search.h"
+
+/*
+ * The fields we can query on
+ */
+enum { F_H, F_D, F_H_MERKLE, F_A, F_K, F_W, F_N, F_M,
+       F_SIG_SIZE, F_SIG_TIME, F_VER_TIME, NUM_FIELD };
+static const char *field_name[ NUM_FIELD ] = {
+    "h", "d", "h_merkle", "a", "k", "w", "n", "m",
+    "sig_size", "sig_time", "ver_time",
+};
+
+/* The fields we index (in the order they appear in the index file) */
+static const int indexed_field[ DUMP_NUM_INDEX ] = {
+    F_SIG_SIZE, F_SIG_TIME, F_VER_TIME, F_H, F_A,
+};
+
+static uint32_t field_value( const struct dump_record *r, int field ) {
+    switch (field) {
+    case F_H: return r->h;
+    case F_D: return r->d;
+    case F_H_MERKLE: return r->h / r->d;
+    case F_A: return r->a;
+    case F_K: return r->k;
+    case F_W: return r->w;
+    case F_N: return r->n;
+    case F_M: return r->m;
+    case F_SIG_SIZE: return r->sig_size;
+    case F_SIG_TIME: return r->sig_time;
+    case F_VER_TIME: return r->ver_time;
+    }
+    return 0;
+}
+
+static int lookup_field( const char *name, size_t len ) {
+    int i;
+    for (i=0; i<NUM_FIELD; i++) {
+        if (strlen( field_name[i] ) == len &&
+                0 == strncmp( field_name[i], name, len )) return i;
+    }
+    return -1;
+}
+
+/*
+ * Memory map a file (read only); returns NULL on failure
+ */
+static const void *map_file( const char *filename, size_t *size,
+                             struct stat *st ) {
+    int fd = open( filename, O_RDONLY );
+    if (fd < 0) return 0;
+    if (0 != fstat( fd, st ) || st->st_size == 0) {
+        close( fd );
+        return 0;
+    }
+    *size = st->st_size;
+    void *base = mmap( 0, *size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    return base == MAP_FAILED ? 0 : base;
+}
+
+/*
+ * The query, once we've parsed it: the range each field must be in
+ */
+struct query {
+    uint64_t lo[ NUM_FIELD ], hi[ NUM_FIELD ];  /* Inclusive */
+    int sort;                   /* The field to list them in order of */
+};
+
+/*
+ * Parse the where= string; a comma separated list of conditions such as
+ * sig_size<8000 (the operators are <, <=, >, >= and =).  The value may be
+ * given as a power of two, for example sig_time<2^20
+ * Returns 0 on a syntax error
+ */
+static int parse_where( struct query *q, const char *where ) {
+    int f;
+    for (f=0; f<NUM_FIELD; f++) {
+        q->lo[f] = 0;
+        q->hi[f] = UINT32_MAX;
+    }
+    if (!where) return 1;
+
+    while (*where) {
+        size_t len = strcspn( where, "<>=" );
+        f = lookup_field( where, len );
+        if (f < 0) {
+            fprintf( stderr, "Unknown field in %s\n", where );
+            return 0;
+        }
+        where += len;
+        if (*where != '<' && *where != '>' && *where != '=') {
+            fprintf( stderr, "Expected <, > or = in %s\n", where - len );
+            return 0;
+        }
+        char op = *where++;
+        int or_equal = 0;
+        if (op != '=' && *where == '=') {
+            or_equal = 1;
+            where++;
+        }
+
+        char *end;
+        double value = strtod( where, &end );
+        if (end == where) {
+            fprintf( stderr, "Expected a number in %s\n", where );
+            return 0;
+        }
+        if (*end == '^') {
+            where = end + 1;
+            double exponent = strtod( where, &end );
+            if (end == where) {
+                fprintf( stderr, "Expected an exponent in %s\n", where );
+                return 0;
+            }
+            value = pow( value, exponent );
+        }
+        where = end;
+        if (*where == ',') {
+            where++;
+        } else if (*where) {
+            fprintf( stderr, "Unexpected %s\n", where );
+            return 0;
+        }
+
+        /* Narrow the range of that field */
+        double lo, hi;
+        switch (op) {
+        case '<': lo = 0; hi = or_equal ? floor(value) : ceil(value) - 1; break;
+        case '>': lo = or_equal ? ceil(value) : floor(value) + 1; hi = UINT32_MAX; break;
+        default:  lo = ceil(value); hi = floor(value); break;
+        }
+        if (lo > q->lo[f]) q->lo[f] = lo > UINT32_MAX ? (uint64_t)UINT32_MAX+1 : lo;
+        if (hi < q->hi[f]) q->hi[f] = hi < 0 ? 0 : hi;
+        if (hi < 0) q->lo[f] = 1;   /* Nothing is less than 0 */
+    }
+    return 1;
+}
+
+static int matches( const struct query *q, const struct dump_record *r ) {
+    int f;
+    for (f=0; f<NUM_FIELD; f++) {
+        uint32_t v = field_value( r, f );
+        if (v < q->lo[f] || v > q->hi[f]) return 0;
+    }
+    return 1;
+}
+
+static int compare_u64( const void *a, const void *b ) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Build the index on one field; order[] gets the record numbers, in order
+ * of that field (and record number within that).  Returns 0 if we ran out
+ * of memory
+ */
+static int build_index( const struct dump_record *rec, uint32_t num_records,
+                        int field, uint32_t *order ) {
+    uint64_t *key = malloc( (size_t)num_records * sizeof *key + 1 );
+    if (!key) return 0;
+    uint32_t i;
+    for (i = 0; i < num_records; i++) {
+        key[i] = ((uint64_t)field_value( &rec[i], field ) << 32) | i;
+    }
+    qsort( key, num_records, sizeof *key, compare_u64 );
+    for (i = 0; i < num_records; i++) {
+        order[i] = (uint32_t)key[i];
+    }
+    free( key );
+    return 1;
+}
+
+/*
+ * Get the indexes of the dump file; we use the index file if it's there
+ * (and up to date), otherwise we build them, and try to save them for next
+ * time.  order[i] is set to the i-th index.  Returns 0 on failure
+ */
+struct indexes {
+    const uint32_t *order[ DUMP_NUM_INDEX ];
+    const void *map;            /* The index file, if we mapped it */
+    size_t map_size;
+    uint32_t *built;            /* The indexes, if we built them */
+};
+
+static int get_indexes( struct indexes *ix, const char *filename,
+                        const struct dump_header *header,
+                        const struct stat *dump_st ) {
+    char *idx_name = malloc( strlen( filename ) + 10 );
+    if (!idx_name) return 0;
+    sprintf( idx_name, "%s.idx", filename );
+    uint64_t n = header->num_records;
+    int i;
+
+    ix->map = 0;
+    ix->map_size = 0;
+    ix->built = 0;
+
+    /* First see if there's a usable index file */
+    struct stat st;
+    size_t size;
+    const struct dump_index_header *ih = map_file( idx_name, &size, &st );
+    if (ih) {
+        if (size == sizeof *ih + DUMP_NUM_INDEX * n * sizeof (uint32_t) &&
+                0 == memcmp( ih->magic, DUMP_INDEX_MAGIC, sizeof ih->magic ) &&
+                ih->version == DUMP_INDEX_VERSION &&
+                ih->num_index == DUMP_NUM_INDEX &&
+                ih->num_records == n &&
+                ih->dump_size == (uint64_t)dump_st->st_size &&
+                ih->dump_mtime == (int64_t)dump_st->st_mtim.tv_sec &&
+                ih->dump_mtime_ns == (int64_t)dump_st->st_mtim.tv_nsec) {
+            ix->map = ih;
+            ix->map_size = size;
+            for (i=0; i<DUMP_NUM_INDEX; i++) {
+                ix->order[i] = (const uint32_t *)(ih + 1) + i * n;
+            }
+            free( idx_name );
+            return 1;
+        }
+        munmap( (void *)ih, size );     /* Out of date */
+    }
+
+    /* Nope; build them */
+    const struct dump_record *rec = (const void *)(header + 1);
+    ix->built = malloc( DUMP_NUM_INDEX * n * sizeof *ix->built + 1 );
+    if (!ix->built) {
+        free( idx_name );
+        return 0;
+    }
+    for (i=0; i<DUMP_NUM_INDEX; i++) {
+        if (!build_index( rec, n, indexed_field[i], ix->built + i * n )) {
+            free( ix->built );
+            free( idx_name );
+            return 0;
+        }
+        ix->order[i] = ix->built + i * n;
+    }
+
+    /*
+     * And save them.  We write them to a temporary file and rename it, so
+     * that a concurrent query never sees a half written index.  If we can't
+     * save them, that's not fatal; we just have to rebuild them next time
+     */
+    char *tmp_name = malloc( strlen( idx_name ) + 10 );
+    FILE *f = tmp_name ? fopen( strcat( strcpy( tmp_name, idx_name ), ".tmp" ),
+                                "wb" ) : 0;
+    if (f) {
+        static struct writer out;
+        struct dump_index_header h;
+        memset( &h, 0, sizeof h );
+        memcpy( h.magic, DUMP_INDEX_MAGIC, sizeof h.magic );
+        h.version = DUMP_INDEX_VERSION;
+        h.num_index = DUMP_NUM_INDEX;
+        h.num_records = n;
+        h.dump_size = dump_st->st_size;
+        h.dump_mtime = dump_st->st_mtim.tv_sec;
+        h.dump_mtime_ns = dump_st->st_mtim.tv_nsec;
+        writer_init( &out, f );
+        write_bytes( &out, &h, sizeof h );
+        write_bytes( &out, ix->built, DUMP_NUM_INDEX * n * sizeof *ix->built );
+        int ok = writer_flush( &out );
+        if (0 != fclose( f )) ok = 0;
+        if (!ok || 0 != rename( tmp_name, idx_name )) {
+            fprintf( stderr, "Unable to save the index to %s\n", idx_name );
+            remove( tmp_name );
+        }
+    }
+    free( tmp_name );
+    free( idx_name );
+    return 1;
+}
+
+/*
+ * Find the part of an index where the field is within [lo, hi]; that's
+ * order[*begin] through order[*end-1]
+ */
+static void index_range( const struct dump_record *rec, const uint32_t *order,
+                         uint32_t n, int field, uint64_t lo, uint64_t hi,
+                         uint32_t *begin, uint32_t *end ) {
+    uint32_t a = 0, b = n;          /* First entry >= lo */
+    while (a < b) {
+        uint32_t mid = a + (b - a) / 2;
+        if (field_value( &rec[ order[mid] ], field ) < lo) a = mid + 1;
+        else b = mid;
+    }
+    *begin = a;
+    b = n;                          /* First entry > hi */
+    while (a < b) {
+        uint32_t mid = a + (b - a) / 2;
+        if (field_value( &rec[ order[mid] ], field ) <= hi) a = mid + 1;
+        else b = mid;
+    }
+    *end = a;
+    if (*end < *begin) *end = *begin;
+}
+
+/*
+ * List a parameter set we found
+ */
+static void write_record( struct writer *out, const struct dump_record *r,
+                          int format ) {
+    if (format == FORMAT_JSONL) {
+        write_str( out, "{\"h\":" );        write_uint( out, r->h );
+        write_str( out, ",\"d\":" );        write_uint( out, r->d );
+        write_str( out, ",\"h_merkle\":" ); write_uint( out, r->h / r->d );
+        write_str( out, ",\"a\":" );        write_uint( out, r->a );
+        write_str( out, ",\"k\":" );        write_uint( out, r->k );
+        write_str( out, ",\"w\":" );        write_uint( out, r->w );
+        write_str( out, ",\"n\":" );        write_uint( out, r->n );
+        write_str( out, ",\"m\":" );        write_uint( out, r->m );
+        write_str( out, ",\"sig_size\":" ); write_uint( out, r->sig_size );
+        write_str( out, ",\"sig_time\":" ); write_uint( out, r->sig_time );
+        write_str( out, ",\"ver_time\":" ); write_uint( out, r->ver_time );
+        write_str( out, "}\n" );
+    } else {
+        char line[200];
+        int len = sprintf( line, "%3u %3u %3u %3u %4u %4u %3u %3u %9u %11u %9u\n",
+                           r->h, r->d, r->h / r->d, r->a, r->k, r->w,
+                           r->n, r->m, r->sig_size, r->sig_time,
+                           r->ver_time );
+        write_bytes( out, line, len );
+    }
+}
+
+/*
+ * Run a query over a dump file, and list what we find on stdout
+ * filename - The dump file
+ * where    - The conditions (see parse_where); NULL means everything
+ * sort     - The field to list them in order of (smallest first); NULL
+ *            means sig_size
+ * top      - The most to list; 0 means all of them
+ * format   - FORMAT_JSONL for JSON objects, otherwise a text table
+ * Returns 0 on failure
+ */
+int run_query( const char *filename, const char *where, const char *sort,
+               unsigned long top, int format ) {
+    struct timespec start, stop;
+    clock_gettime( CLOCK_MONOTONIC, &start );
+
+    struct query q;
+    if (!parse_where( &q, where )) return 0;
+    q.sort = sort ? lookup_field( sort, strlen( sort )) : F_SIG_SIZE;
+    if (q.sort < 0) {
+        fprintf( stderr, "Unknown field %s\n", sort );
+        return 0;
+    }
+
+    struct stat st;
+    size_t size;
+    const struct dump_header *header = map_file( filename, &size, &st );
+    if (!header) {
+        fprintf( stderr, "Unable to read %s\n", filename );
+        return 0;
+    }
+    if (size < sizeof *header ||
+            0 != memcmp( header->magic, DUMP_MAGIC, sizeof header->magic ) ||
+            header->version != DUMP_VERSION ||
+            header->record_size != sizeof (struct dump_record) ||
+            header->num_records > UINT32_MAX ||
+            header->num_records > (size - sizeof *header) /
+                                          sizeof (struct dump_record)) {
+        fprintf( stderr, "%s is not a dump file\n", filename );
+        munmap( (void *)header, size );
+        return 0;
+    }
+    const struct dump_record *rec = (const void *)(header + 1);
+    uint32_t n = header->num_records;
+
+    struct indexes ix;
+    if (!get_indexes( &ix, filename, header, &st )) {
+        fprintf( stderr, "Get a real computer you cheapskate\n" );
+        munmap( (void *)header, size );
+        return 0;
+    }
+
+    /*
+     * Find which index narrows it down the most, and where the sort field
+     * is (if it is indexed)
+     */
+    int i, best = 0, sort_index = -1;
+    uint32_t begin[ DUMP_NUM_INDEX ], end[ DUMP_NUM_INDEX ];
+    for (i=0; i<DUMP_NUM_INDEX; i++) {
+        int f = indexed_field[i];
+        index_range( rec, ix.order[i], n, f, q.lo[f], q.hi[f],
+                     &begin[i], &end[i] );
+        if (end[i] - begin[i] < end[best] - begin[best]) best = i;
+        if (f == q.sort) sort_index = i;
+    }
+
+    /*
+     * If we're sorting by an indexed field, and we either want only the
+     * first few, or that index doesn't have many more to scan than the best
+     * one, walk that index in order
+     */
+    uint32_t best_count = end[best] - begin[best];
+    int walk = sort_index >= 0 &&
+               (top || end[sort_index] - begin[sort_index] <= 4 * best_count);
+
+    static struct writer out;
+    writer_init( &out, stdout );
+    if (format != FORMAT_JSONL) {
+        write_str( &out, "  h   d  h'   a    k    w   n   m  sig_size    sig_time  ver_time\n" );
+    }
+    unsigned long found = 0, scanned = 0;
+    uint32_t j;
+    if (walk) {
+        const uint32_t *order = ix.order[ sort_index ];
+        for (j = begin[sort_index]; j < end[sort_index]; j++) {
+            scanned++;
+            if (!matches( &q, &rec[ order[j] ] )) continue;
+            write_record( &out, &rec[ order[j] ], format );
+            if (++found == top) break;
+        }
+    } else {
+        /* Collect everything that matches, and sort them */
+        uint64_t *key = malloc( (size_t)best_count * sizeof *key + 1 );
+        if (!key) {
+            fprintf( stderr, "Get a real computer you cheapskate\n" );
+            found = 0;
+        } else {
+            const uint32_t *order = ix.order[ best ];
+            for (j = begin[best]; j < end[best]; j++) {
+                scanned++;
+                if (!matches( &q, &rec[ order[j] ] )) continue;
+                key[found++] = ((uint64_t)field_value( &rec[ order[j] ],
+                                                       q.sort ) << 32) |
+                               order[j];
+            }
+            qsort( key, found, sizeof *key, compare_u64 );
+            if (top && found > top) found = top;
+            for (j = 0; j < found; j++) {
+                write_record( &out, &rec[ (uint32_t)key[j] ], format );
+            }
+            free( key );
+        }
+    }
+    int ok = writer_flush( &out );
+    if (!ok) fprintf( stderr, "Error writing output\n" );
+
+    clock_gettime( CLOCK_MONOTONIC, &stop );
+    fprintf( stderr, "%lu listed; scanned %lu of %u records (%s index), %.2f ms\n",
+             found, scanned, n,
+             field_name[ indexed_field[ walk ? sort_index : best ] ],
+             (stop.tv_sec - start.tv_sec) * 1e3 +
+                            (stop.tv_nsec - start.tv_nsec) / 1e6 );
+
+    if (ix.map) munmap( (void *)ix.map, ix.map_size );
+    free( ix.built );
+    munmap( (void *)header, size );
+    return ok;
+}
@@ -0,0 +1,2 @@
+int run_query( const char *filename, const char *where, const char *sort,
+               unsigned long top, int format );
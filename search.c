@@ -13,6 +13,12 @@
 #include <limits.h>
 #include "search.h"
 #include "gamma.h"
+#include "writer.h"
+#include "curves.h"
+#include "dump.h"
+#include "cost.h"
+#include "slhdsa.h"
+#include <time.h>
 
 #define MAX_K   100 /* SANITY LIMIT */
                     /* Don't bother checking any parameter set with more */
@@ -40,139 +46,1540 @@ struct parameter_set {
     unsigned sig_size;           /* Size of the signature */
     unsigned sig_time;           /* Number of hashes computed during signing */
     unsigned ver_time;           /* Number of hashes computed during verif */
+    unsigned keygen_time;        /* Number of hashes computed during keygen */
+    unsigned peak_mem;           /* Bytes of memory the signer needs */
+    int overuse;                 /* 100 * log2 of the number of signatures */
+                                 /* at the secondary security level (only */
+                                 /* set for the ones we list) */
+    float sign_us;               /* Predicted sign and verify times on this */
+    float ver_us;                /* host (only if params->predict) */
+    float sign_lanes;            /* Lane-packed sign and verify costs */
+    float ver_lanes;             /* (only if params->lanes) */
+    float sign_lanes_us;         /* The same, as predicted times with the */
+    float ver_lanes_us;          /* multi-buffer hashes (only if both) */
+    float sign_cores;            /* Sign latency with params->cores cores */
+    float sign_cached;           /* Amortized sign cost with the top */
+    unsigned char cached_layers; /* this many layers cached (only if */
+                                 /* params->cache_mb) */
+    unsigned char h_top;         /* Height of the top Merkle tree, and how */
+    unsigned char tall;          /* many of the bottom ones are taller than */
+                                 /* the rest (see struct hypertree) */
+    unsigned char k_tall;        /* How many of the k FORS trees are a+1 */
+                                 /* high, rather than a (forsmix=1) */
 };
 
+/*
+ * The shape of the hypertree.  Ordinarily, the d Merkle trees are all the
+ * same height; with mixed=1, they needn't be.  The top tree is top high;
+ * below it come d-1-tall layers of trees base high, and then (at the
+ * bottom) tall layers of trees base+1 high.  h is the total height.
+ *
+ * The signature size and the security depend only on h.  So does the
+ * verify cost, nearly: the message digest splits the hypertree index into
+ * the tree and the leaf in the bottom layer, each rounded up to bytes (see
+ * digest_bytes), so the bottom tree's height can change its length by a
+ * byte, and with hash=sha2, that can cost H_msg another compression call
+ */
+struct hypertree {
+    unsigned h, d;
+    unsigned top, base, tall;
+};
+
+static int is_uniform( const struct hypertree *t ) {
+    return t->top == t->base && t->tall == 0;
+}
+
+/* The height of the trees in layer i (counting down from the top) */
+static unsigned layer_height( const struct hypertree *t, unsigned i ) {
+    if (i == 0) return t->top;
+    return i < t->d - t->tall ? t->base : t->base + 1;
+}
+
+/* The height of the tallest tree */
+static unsigned tallest_tree( const struct hypertree *t ) {
+    unsigned lower = t->base + (t->tall > 0);
+    return t->d > 1 && lower > t->top ? lower : t->top;
+}
+
+/*
+ * Add up a cost over the d trees (one per layer), given what it is for a
+ * tree of the top height, of the base height and of the base+1 height
+ */
+static double layer_sum( const struct hypertree *t, double top, double base,
+                         double tall ) {
+    if (is_uniform( t )) return t->d * base;
+    return top + (t->d - 1 - t->tall) * base + t->tall * tall;
+}
+
+/* The shape of the hypertree of a parameter set we found */
+static struct hypertree shape_of( const struct parameter_set *p ) {
+    struct hypertree t;
+    t.h = p->h; t.d = p->d;
+    t.top = p->h_top; t.tall = p->tall;
+    t.base = p->d > 1 ? (p->h - p->h_top - p->tall) / (p->d - 1) : p->h_top;
+    return t;
+}
+
+/*
+ * Which costs we rank parameter sets by (once we've sorted by size); the
+ * serial ones, unless budget= said otherwise.  do_search sets this before
+ * it sorts
+ */
+static int rank_budget = BUDGET_SERIAL;
+
+static double sign_rank( const struct parameter_set *p ) {
+    switch (rank_budget) {
+    case BUDGET_LANES: return p->sign_lanes;
+    case BUDGET_CORES: return p->sign_cores;
+    case BUDGET_CACHED: return p->sign_cached;
+    default:           return p->sig_time;
+    }
+}
+
+static double ver_rank( const struct parameter_set *p ) {
+    switch (rank_budget) {
+    case BUDGET_LANES: return p->ver_lanes;
+    default:           return p->ver_time;
+    }
+}
+
+/*
+ * What we rank parameter sets by first; the signature size, unless
+ * objective=weighted gave us weights for the size and the sign and verify
+ * costs (do_search sets these before it sorts)
+ */
+static int rank_objective = OBJECTIVE_SIZE;
+static double weight_byte, weight_sign, weight_ver;
+
+static double objective( const struct parameter_set *p ) {
+    switch (rank_objective) {
+    case OBJECTIVE_WEIGHTED:
+        return weight_byte * p->sig_size + weight_sign * sign_rank(p) +
+               weight_ver * ver_rank(p);
+    default:
+        return p->sig_size;
+    }
+}
+
+/*
+ * The order we compare things in; by default, the signature size (or
+ * weighted cost) first, then the sign cost, then the verify cost.  rank=
+ * can put the sign or verify cost first instead (and then the others move
+ * down).  do_search sets this before it sorts
+ */
+#define KEY_OBJECTIVE 0
+#define KEY_SIGN      1
+#define KEY_VERIFY    2
+static const int rank_order[][3] = {
+    [RANK_SIZE]   = { KEY_OBJECTIVE, KEY_SIGN, KEY_VERIFY },
+    [RANK_SIGN]   = { KEY_SIGN, KEY_OBJECTIVE, KEY_VERIFY },
+    [RANK_VERIFY] = { KEY_VERIFY, KEY_OBJECTIVE, KEY_SIGN },
+};
+static const int *rank_keys = rank_order[ RANK_SIZE ];
+
+static double rank_key( const struct parameter_set *p, int key ) {
+    switch (key) {
+    case KEY_SIGN:   return sign_rank( p );
+    case KEY_VERIFY: return ver_rank( p );
+    default:         return objective( p );
+    }
+}
+
+/*
+ * The key we rank by first; the three lists are merged on just that
+ */
+static double primary_key( const struct parameter_set *p ) {
+    return rank_key( p, rank_keys[0] );
+}
+
 /*
  * This compares two parameter sets and returns 1 or -1 dependong on which
  * one we consider 'better'
  */
 static int my_compare( struct parameter_set *a, struct parameter_set *b ) {
-    /* Smallest signature size wins */
-    if (a->sig_size < b->sig_size) return  1;
-    if (a->sig_size > b->sig_size) return -1;
+    int i;
+    for (i = 0; i < 3; i++) {
+        /* Smallest one wins; if equal, try the next key */
+        double key_a = rank_key( a, rank_keys[i] );
+        double key_b = rank_key( b, rank_keys[i] );
+        if (key_a < key_b) return  1;
+        if (key_a > key_b) return -1;
+    }
+
+    /* These two are identical as far as we can tell */
+    return 0;
+}
+
+/*
+ * This takes two lists of parameter sets (both in 'best first' order), and
+ * merges them into a single list (in 'best first' order
+ */
+static struct parameter_set *my_merge( struct parameter_set *a, struct parameter_set *b ) {
+    struct parameter_set *list = 0;
+    struct parameter_set **tail = &list;
+
+    while (a && b) {
+        struct parameter_set *p;
+        if (my_compare( a, b ) >= 0) {
+            p = a;
+            a = a->link;
+        } else {
+            p = b;
+            b = b->link;
+        }
+        *tail = p;
+        tail = &p->link;
+    }
+    if (a) {
+        *tail = a;
+    } else {
+        *tail = b;
+    }
+    return list;
+}
+
+static int ilog2( unsigned n ) {
+    int i;
+    for (i=0; n>1; i++, n >>= 1) {
+	;
+    }
+    return i;
+}
+
+/*
+ * This sorts the list of parameter sets into 'best first' order
+ * It uses a merge sort
+ */
+static struct parameter_set *my_sort( struct parameter_set *list ) {
+#define NUM_BIN 20    /* This routine works even if we get more than */
+                      /* 2^20 parameter sets, it just goes slower */
+    struct parameter_set *bins[ NUM_BIN ] = { 0 }; /* bin[i] is either */
+                      /* NULL or a list of precisely 2^i parameter sets in */
+                      /* best-first order (except for i==19; we use that */
+                      /* as an overflow if we get more than 2^20) */
+
+    while (list) {
+        /* Extract the next time in the input list; make that a list with */
+        /* a single item */
+        struct parameter_set *p = list;
+        list = p->link;
+        p->link = 0;
+
+        /* Ripple-add that to the lists in bin */
+        int i;
+        for (i=0; i<NUM_BIN; i++) {
+            /* p is a sorted list of 2^i items */
+
+            if (!bins[i]) {
+                /* That bin is empty; insert it onto the list */
+                bins[i] = p;
+                break;
+            }
+
+            /* That bin also has a list; merge them (and empty the bin) */
+            p = my_merge( bins[i], p );
+            bins[i] = 0;
+            /* p is a sorted list of 2^{i+1} items */
+        }
+
+        /* If we ran out of bins, store the list in the overflow bin */
+        if (i == NUM_BIN) {
+            bins[NUM_BIN-1] = p;
+        }
+    }
+
+    /*
+     * We sorted the entire input list into bins; combine the bins
+     */
+    struct parameter_set *p = 0;
+    for (int i=0; i<NUM_BIN; i++) {
+        p = my_merge( bins[i], p );
+    }
+
+    return p;
+}
+
+/*
+ * The fewest FORS trees of height a that could possibly be at sec_level
+ * after 2^m signatures with a hypertree of height h.  Equation (1) is
+ * lambda/ln 2 - log2 of the sum over g of lambda^g/g! * (1-(1-2^-a)^g)^k;
+ * every (1-(1-2^-a)^g) is at least 2^-a, so the sum is at least
+ * (e^lambda - 1) * 2^-ak, and the security level is no more than
+ * a*k - log2(1 - e^-lambda).  We leave half a bit of slack, as the
+ * evaluators aren't exact
+ */
+static unsigned fors_k_min( double sec_level, double m, unsigned h,
+                            unsigned a ) {
+    double lambda = exp2( m - h );
+    double bits = sec_level + log2( -expm1( -lambda ) ) - 0.5;
+    if (bits <= a) return 1;
+    return (unsigned)ceil( bits / a );
+}
+
+/*
+ * The top= mode keeps just the best parameter sets found so far, in a heap
+ * with the worst of them on top (so we can tell quickly whether a new one
+ * gets in, and which one it pushes out)
+ */
+struct top_heap {
+    struct parameter_set **set;
+    unsigned count;
+    unsigned size;          /* The most we keep */
+};
+
+static void heap_sift_down( struct top_heap *heap, unsigned i ) {
+    struct parameter_set *p = heap->set[i];
+    for (;;) {
+        unsigned c = 2*i + 1;
+        if (c >= heap->count) break;
+        if (c+1 < heap->count && my_compare( heap->set[c+1], heap->set[c] ) < 0) c++;
+        if (my_compare( heap->set[c], p ) >= 0) break;
+        heap->set[i] = heap->set[c];
+        i = c;
+    }
+    heap->set[i] = p;
+}
+
+/*
+ * The worst one we're keeping, if we've got as many as we need (0 if not;
+ * then anything gets in)
+ */
+static const struct parameter_set *heap_worst( const struct top_heap *heap ) {
+    return heap->count == heap->size ? heap->set[0] : 0;
+}
+
+/*
+ * The largest signature that could still be listed; a limit of max_sig
+ * (if given), the worst one on a full top= heap (if we're pruning on that)
+ * and the size at which we're pruning this w class (if we are)
+ */
+static unsigned listable_size( unsigned max_sig, const struct top_heap *heap,
+                               int top_prune, double prune_at ) {
+    unsigned size = max_sig ? max_sig : UINT_MAX;
+    if (top_prune && heap_worst( heap ) && heap_worst( heap )->sig_size < size) {
+        size = heap_worst( heap )->sig_size;
+    }
+    if (prune_at < size) size = prune_at;
+    return size;
+}
+
+/*
+ * Offer p to the heap; it takes it over (and frees it, or whatever it
+ * pushes out)
+ */
+static void heap_add( struct top_heap *heap, struct parameter_set *p ) {
+    if (heap->count < heap->size) {
+        /* There's room; sift it up */
+        unsigned i = heap->count++;
+        while (i > 0 && my_compare( heap->set[(i-1)/2], p ) > 0) {
+            heap->set[i] = heap->set[(i-1)/2];
+            i = (i-1)/2;
+        }
+        heap->set[i] = p;
+    } else if (my_compare( p, heap->set[0] ) > 0) {
+        free( heap->set[0] );
+        heap->set[0] = p;
+        heap_sift_down( heap, 0 );
+    } else {
+        free( p );
+    }
+}
+
+/*
+ * Empty the heap into a list, best first
+ */
+static struct parameter_set *heap_to_list( struct top_heap *heap ) {
+    struct parameter_set *list = 0;
+    while (heap->count > 0) {
+        struct parameter_set *p = heap->set[0];
+        heap->set[0] = heap->set[ --heap->count ];
+        if (heap->count) heap_sift_down( heap, 0 );
+        p->link = list;
+        list = p;
+    }
+    return list;
+}
+
+/*
+ * The Pareto frontier mode: we list every parameter set which no other
+ * parameter set beats in all of signature size, sign cost, verify cost and
+ * overuse (that is, is at least as good in all four, and better in one)
+ *
+ * We sort them by size (and then the others); then a parameter set can
+ * only be beaten by one before it, so we go through them in order, and
+ * keep the ones that nothing on the frontier so far beats.  To find that
+ * quickly, we keep the frontier in a k-d tree on the other three (with
+ * the overuse negated, so that smaller is better in all of them), where
+ * each node also has the smallest of each of those in its subtree; that
+ * way, we can skip any subtree that has nothing that small
+ *
+ * Computing the overuse is what takes the time, and most parameter sets
+ * are nowhere near the frontier; so before we do, we look up the best
+ * overuse of the ones on the frontier which are no worse in the other
+ * three, and check (with one security level evaluation) whether this one
+ * can beat that
+ */
+struct kd_node {
+    struct parameter_set *p;
+    double key[3];          /* Sign cost, verify cost, -overuse */
+    double min[3];          /* The smallest of each in this subtree */
+    int child[2];           /* -1 if none */
+};
+
+static void pareto_keys( const struct parameter_set *p, double *key ) {
+    key[0] = sign_rank( p );
+    key[1] = ver_rank( p );
+    key[2] = -p->overuse;
+}
+
+/*
+ * This sorts by size, then sign and verify cost, and then overuse (which
+ * we compute only for those that are tied in all the others)
+ */
+static int pareto_compare( const void *x, const void *y ) {
+    const struct parameter_set *a = *(struct parameter_set * const *)x;
+    const struct parameter_set *b = *(struct parameter_set * const *)y;
+    if (a->sig_size != b->sig_size) return a->sig_size < b->sig_size ? -1 : 1;
+    double key_a[3], key_b[3];
+    pareto_keys( a, key_a );
+    pareto_keys( b, key_b );
+    int i;
+    for (i = 0; i < 3; i++) {
+        if (key_a[i] != key_b[i]) return key_a[i] < key_b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+/*
+ * The best (smallest) -overuse in the subtree at node n, among the ones
+ * whose sign and verify costs are no more than key's; best is what we've
+ * found so far
+ */
+static void kd_best( const struct kd_node *tree, int n, const double *key,
+                     double *best ) {
+    while (n >= 0) {
+        const struct kd_node *node = &tree[n];
+        if (node->min[0] > key[0] || node->min[1] > key[1] ||
+                                     node->min[2] >= *best) {
+            return;         /* Nothing down here is that good */
+        }
+        if (node->key[0] <= key[0] && node->key[1] <= key[1] &&
+                                      node->key[2] < *best) {
+            *best = node->key[2];
+        }
+        kd_best( tree, node->child[0], key, best );
+        n = node->child[1];
+    }
+}
+
+/*
+ * Is the parameter set with this size and these keys beaten by anything in
+ * the subtree at node n?  Everything in the tree is no bigger
+ */
+static int kd_beaten( const struct kd_node *tree, int n, unsigned size,
+                      const double *key ) {
+    while (n >= 0) {
+        const struct kd_node *node = &tree[n];
+        if (node->min[0] > key[0] || node->min[1] > key[1] ||
+                                     node->min[2] > key[2]) {
+            return 0;       /* Nothing down here is that good */
+        }
+        if (node->key[0] <= key[0] && node->key[1] <= key[1] &&
+                                      node->key[2] <= key[2] &&
+            (node->p->sig_size < size || node->key[0] < key[0] ||
+             node->key[1] < key[1] || node->key[2] < key[2])) {
+            return 1;
+        }
+        if (kd_beaten( tree, node->child[0], size, key )) return 1;
+        n = node->child[1];
+    }
+    return 0;
+}
+
+static void kd_insert( struct kd_node *tree, int count, struct parameter_set *p,
+                       const double *key ) {
+    struct kd_node *node = &tree[count];
+    int i;
+    node->p = p;
+    for (i = 0; i < 3; i++) node->min[i] = node->key[i] = key[i];
+    node->child[0] = node->child[1] = -1;
+    if (count == 0) return;
+
+    /* Walk down to where it goes (splitting on each key in turn) */
+    int n = 0, depth = 0;
+    for (;;) {
+        struct kd_node *parent = &tree[n];
+        for (i = 0; i < 3; i++) {
+            if (key[i] < parent->min[i]) parent->min[i] = key[i];
+        }
+        int side = key[ depth % 3 ] >= parent->key[ depth % 3 ];
+        if (parent->child[side] < 0) {
+            parent->child[side] = count;
+            return;
+        }
+        n = parent->child[side];
+        depth++;
+    }
+}
+
+/*
+ * Is the overuse of p (100 times the log2 of the number of signatures at
+ * sec_level) more than v?  That's the test compute_sigs_at_sec_level makes
+ * when it gets to v
+ */
+static int overuse_above( const struct parameter_set *p, int v,
+                          double sec_level ) {
+    if (v < 0) return 1;
+    return compute_sec_level_mixed( v/100 + (v%100) * 0.01 + 0.005,
+                              p->h, p->a, p->k, p->k_tall ) >= sec_level;
+}
+
+/*
+ * This gives the same answer as compute_sigs_at_sec_level (the security
+ * level only goes down as we sign more), but it binary searches the 0.01
+ * steps, rather than going through them one at a time; and it gives up at
+ * max_overuse.  We step through the integers the same way it does (as the
+ * evaluation gets slow well past the answer, we don't want to overshoot)
+ */
+static int overuse_bisect( const struct parameter_set *p, double sec_level,
+                           int max_overuse ) {
+    int lower;
+    for (lower = 0;; lower++) {
+        if (100*lower >= max_overuse) return max_overuse;
+        if (compute_sec_level_mixed( lower + 1, p->h, p->a, p->k,
+                                     p->k_tall ) < sec_level) break;
+    }
+    int low = 0, high = 100;    /* The hundredths are in [low, high] */
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (overuse_above( p, 100*lower + mid, sec_level )) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    int overuse = 100*lower + low;
+    return overuse < max_overuse ? overuse : max_overuse;
+}
+
+/*
+ * The overuse depends only on h, a and k (and k_tall), and many parameter
+ * sets share those (they differ in w and d); so we remember what we computed
+ */
+struct overuse_memo {
+    unsigned *key;          /* h, a, k and k_tall packed (see memo_overuse) */
+                            /* or 0 if empty */
+    int *overuse;
+    unsigned mask;
+    unsigned computed;
+    int max_overuse;        /* We don't look beyond this */
+    int exact;              /* Or, if set, compute it just as */
+                            /* compute_sigs_at_sec_level does */
+};
+
+static int memo_overuse( struct overuse_memo *memo, unsigned test_sec_level,
+                         const struct parameter_set *p ) {
+    unsigned key = (((p->h << 5) | p->a) << 7 | p->k) << 7 | p->k_tall;
+    unsigned slot = (key * 0x9e3779b9u) & memo->mask;
+    while (memo->key[slot] && memo->key[slot] != key) {
+        slot = (slot + 1) & memo->mask;
+    }
+    if (!memo->key[slot]) {
+        memo->key[slot] = key;
+        memo->overuse[slot] = memo->exact ?
+                   compute_sigs_at_sec_level_mixed( test_sec_level,
+                                            p->h, p->a, p->k, p->k_tall ) :
+                   overuse_bisect( p, test_sec_level, memo->max_overuse );
+        memo->computed++;
+    }
+    return memo->overuse[slot];
+}
+
+/*
+ * Compute the Pareto frontier of the parameter sets on list; this returns
+ * the ones on it (in no particular order) and frees the rest.  We consider
+ * overuse beyond max_s (if given) to be no better than max_s.  With stats,
+ * we say (to stderr) how much work that was
+ */
+static struct parameter_set *pareto_frontier( struct parameter_set *list,
+                                 unsigned test_sec_level, int max_s,
+                                 int stats ) {
+    unsigned count = 0, i;
+    struct parameter_set *p;
+    for (p = list; p; p = p->link) count++;
+    if (count == 0) return 0;
+
+    struct parameter_set **set = malloc( count * sizeof *set );
+    struct kd_node *tree = malloc( count * sizeof *tree );
+    struct overuse_memo memo;
+    for (memo.mask = 1; memo.mask < 2*count; memo.mask <<= 1) ;
+    memo.key = calloc( memo.mask, sizeof *memo.key );
+    memo.overuse = malloc( memo.mask * sizeof *memo.overuse );
+    memo.mask--;
+    memo.computed = 0;
+    if (!set || !tree || !memo.key || !memo.overuse) {
+        fprintf( stderr, "Get a real computer you cheapskate\n" );
+        exit(1);
+    }
+    int max_overuse = max_s ? 100*max_s : INT_MAX;
+    memo.max_overuse = max_overuse;
+    memo.exact = 0;
+
+    /* Sort them, with the overuse not known yet (-1) */
+    for (i = 0, p = list; p; p = p->link, i++) {
+        set[i] = p;
+        p->overuse = -1;
+    }
+    qsort( set, count, sizeof *set, pareto_compare );
+
+    /*
+     * Where several are tied in all of size and costs, the one with the
+     * better overuse needs to come first; compute those, and sort them
+     * again
+     */
+    unsigned j;
+    for (i = 0; i < count; i = j) {
+        for (j = i+1; j < count && !pareto_compare( &set[i], &set[j] ); j++) ;
+        if (j - i > 1) {
+            unsigned t;
+            for (t = i; t < j; t++) {
+                set[t]->overuse = memo_overuse( &memo, test_sec_level, set[t] );
+            }
+            qsort( &set[i], j - i, sizeof *set, pareto_compare );
+        }
+    }
+
+    struct parameter_set *frontier = 0;
+    int on_frontier = 0;
+    unsigned skipped = 0;
+    for (i = 0; i < count; i++) {
+        double key[3];
+        p = set[i];
+        pareto_keys( p, key );
+        if (p->overuse < 0) {
+            /*
+             * If there's one on the frontier that's no worse in the
+             * others, and this can't even match its overuse (this is
+             * the test compute_sigs_at_sec_level makes), it's beaten
+             */
+            double best = HUGE_VAL;
+            kd_best( tree, on_frontier ? 0 : -1, key, &best );
+            if (best != HUGE_VAL && !overuse_above( p, (int)-best - 1,
+                                                    test_sec_level )) {
+                free( p );
+                skipped++;
+                continue;
+            }
+            p->overuse = memo_overuse( &memo, test_sec_level, p );
+            key[2] = -p->overuse;
+        }
+        if (on_frontier && kd_beaten( tree, 0, p->sig_size, key )) {
+            free( p );
+            continue;
+        }
+        kd_insert( tree, on_frontier++, p, key );
+        p->link = frontier;
+        frontier = p;
+    }
+
+    if (stats) {
+        fprintf( stderr, "Pareto frontier: %u of %u parameter sets (%u overuse "
+                         "computations, %u skipped)\n", on_frontier, count,
+                         memo.computed, skipped );
+    }
+    free( set ); free( tree ); free( memo.key ); free( memo.overuse );
+    return frontier;
+}
+
+/*
+ * Convert the given number into ASCII with commas inserted to make reading
+ * large numbers easier
+ * For example: commify(65536) yields "65,536"
+ * This uses a static buffer, the string should be used before this is
+ * called again; don't use it multiple times in the same printf
+ */
+static char *commify( unsigned n ) {
+    static char buffer[100];
+    int z = 100;
+    buffer[--z] = 0;
+    while (n >= 1000) {
+        buffer[--z] = (n%10) + '0'; n /= 10;
+        buffer[--z] = (n%10) + '0'; n /= 10;
+        buffer[--z] = (n%10) + '0'; n /= 10;
+        buffer[--z] = ',';
+    }
+    while (n) {
+        buffer[--z] = (n%10) + '0'; n /= 10;
+    }
+    return &buffer[z];
+}
+
+/*
+ * The number of bytes of message digest the parameter set uses (that is,
+ * what FIPS 205 calls m); the leaf index is in the bottom Merkle tree
+ */
+static int digest_bytes( const struct parameter_set *p ) {
+    struct hypertree t = shape_of( p );
+    unsigned h_leaf = layer_height( &t, t.d - 1 );
+    return divru(p->h - h_leaf, 8) + divru(h_leaf, 8) +
+           divru(p->a*p->k + p->k_tall, 8);
+}
+
+/*
+ * The size of a signature with these parameters (h is the total hypertree
+ * height; how it's split between the d layers doesn't matter).  Each of the
+ * k_tall taller FORS trees has one more node in its authentication path
+ */
+static unsigned sig_bytes( unsigned hash_size, unsigned h, unsigned d,
+                           unsigned wd, unsigned a, unsigned k,
+                           unsigned k_tall ) {
+    return hash_size * (1 + k * (a+1) + k_tall + d * wd + h);
+}
+
+/*
+ * The 'overuse safety' factor; how many times more signatures than we were
+ * asked for we can generate while still at the secondary security level
+ */
+static unsigned overuse_safety( const struct parameter_set *p, unsigned num_sig ) {
+    return (unsigned)pow(2, (float)p->overuse/100 - num_sig );
+}
+
+/*
+ * The predicted time (in microseconds) of a hash operation on this host
+ * (0 if we're not predicting times).  If we were asked to count abstract
+ * hashes, we predict the time for SHA-2
+ */
+static double op_time( const struct search_params *params, int op,
+                       unsigned n, unsigned arg ) {
+    if (!params->predict) return 0;
+    int hash = params->hash ? params->hash : HASH_SHA2;
+    return hash_op_cost( hash, op, n, arg ) *
+           host_prim_time( hash_op_prim( hash, op, n ), 0 );
+}
+
+/*
+ * The predicted time (in microseconds) of a batch of lanes of a hash
+ * operation, done with the multi-buffer hashes (0 unless we're predicting
+ * times for lanes=).  Those do a fixed number of lanes at once, so if
+ * lanes= is more than that, a batch takes several calls (and if it's
+ * less, we still pay for a whole call)
+ */
+static double op_lane_time( const struct search_params *params, int op,
+                            unsigned n, unsigned arg ) {
+    if (!params->predict || !params->lanes) return 0;
+    int hash = params->hash ? params->hash : HASH_SHA2;
+    int prim = hash_op_prim( hash, op, n );
+    unsigned prim_lanes = host_prim_lanes( prim );
+    unsigned calls = (params->lanes + prim_lanes - 1) / prim_lanes;
+    return hash_op_cost( hash, op, n, arg ) * calls * prim_lanes *
+           host_prim_time( prim, 1 );
+}
+
+/*
+ * The lane-packed costs.  A multi-buffer hash does lanes independent
+ * compression calls (or permutations) for about the price of one, so what
+ * we count here is batches: a set of operations that can all be done at
+ * once costs (count/lanes, rounded up) times what one of them costs.  The
+ * rounding up is the tail inefficiency; 67 chains on 8 lanes take 9
+ * batches, not 8.375
+ */
+static double batches( double count, unsigned lanes ) {
+    return ceil( count / lanes );
+}
+
+/*
+ * The lane-packed cost of building one Merkle tree with 2^h_merkle leaves
+ * (which is what signing does d times).  All the chains of all the leaves
+ * are independent, and so are all the nodes at one level of the tree
+ */
+static double lanes_merkle_tree( unsigned lanes, unsigned h_merkle,
+                                 unsigned wd, unsigned w,
+                                 double cost_prf, double cost_f,
+                                 double cost_t_wots, double cost_h ) {
+    double node_tree = ldexp( 1, h_merkle );
+    double cost = batches( node_tree * wd, lanes ) *
+                              (cost_prf + cost_f * (w-1)) +
+                  batches( node_tree, lanes ) * cost_t_wots;
+    unsigned z;
+    for (z = 1; z <= h_merkle; z++) {
+        cost += batches( ldexp( 1, h_merkle - z ), lanes ) * cost_h;
+    }
+    return cost;
+}
+
+/*
+ * The lane-packed cost of building k FORS trees of height a (k_tall of
+ * them a+1); we build all k trees together, a level at a time, starting
+ * with the leaves (so the taller trees have one more level on top)
+ */
+static double lanes_fors( unsigned lanes, unsigned a, unsigned k,
+                          unsigned k_tall, double cost_prf,
+                          double cost_f, double cost_h ) {
+    double cost = batches( ldexp( k, a ) + ldexp( k_tall, a ), lanes ) *
+                               (cost_prf + cost_f);
+    unsigned z;
+    for (z = 1; z <= a; z++) {
+        cost += batches( ldexp( k, a - z ) + ldexp( k_tall, a - z ),
+                         lanes ) * cost_h;
+    }
+    if (k_tall) cost += batches( k_tall, lanes ) * cost_h;
+    return cost;
+}
+
+/*
+ * The expected number of lane-packed F calls to walk the wd Winternitz
+ * chains of a signature to their heads.  The chains in a batch step in
+ * lockstep, so a batch takes as long as its longest chain; if each chain
+ * has a random length from 0 to w-1, the longest of m of them is on
+ * average sum over t=1..w-1 of 1 - (t/w)^m (which is about w*m/(m+1)).
+ * The last batch has just the chains left over
+ */
+static double lanes_chain_walk( unsigned lanes, unsigned wd, unsigned w ) {
+    double longest_full = 0, longest_tail = 0;
+    unsigned t;
+    for (t = 1; t < w; t++) {
+        longest_full += 1 - pow( (double)t / w, lanes );
+        longest_tail += 1 - pow( (double)t / w, wd % lanes );
+    }
+    return (wd / lanes) * longest_full + (wd % lanes ? longest_tail : 0);
+}
+
+/*
+ * The sign latency (after the message hashes) of a signer which spreads a
+ * signature over cores cores.  The d Merkle trees and the k FORS trees are
+ * independent, so it hands them out longest first, each to whichever core
+ * is free first (LPT scheduling); leaf is the cost of a Merkle tree per
+ * leaf, and node the cost we save by not combining the root, and of the k
+ * FORS trees, k_tall take fors_tall (rather than fors).
+ *
+ * Then come the d WOTS signatures.  The bottom one signs the FORS public
+ * key (which combines the k FORS roots, for t_fors), and each one above
+ * signs the root of the tree below, so one core does them in turn, from
+ * the bottom up, each once the root it signs is done.  We don't charge
+ * that core for waiting until the others are free; a WOTS signature is
+ * short next to a tree
+ */
+static double lpt_sign_latency( unsigned cores, const struct hypertree *t,
+                                double leaf, double node,
+                                unsigned k, double fors,
+                                unsigned k_tall, double fors_tall,
+                                double t_fors, double wots_sign ) {
+    /* The tasks, longest first; layer is the Merkle tree layer (counting */
+    /* down from the top), or -1 for a FORS tree */
+    struct { double cost; int layer; } task[ 32 + MAX_K ];
+    unsigned n = 0, i, j;
+    for (i = 0; i < k; i++) {
+        task[n].cost = i < k_tall ? fors_tall : fors;
+        task[n++].layer = -1;
+    }
+    for (i = t->d; i-- > 0; ) {     /* (the bottom ones first on ties) */
+        task[n].cost = ldexp( leaf, layer_height( t, i ) ) - node;
+        task[n++].layer = i;
+    }
+    for (i = 1; i < n; i++) {
+        double v = task[i].cost;
+        int layer = task[i].layer;
+        for (j = i; j > 0 && task[j-1].cost < v; j--) task[j] = task[j-1];
+        task[j].cost = v; task[j].layer = layer;
+    }
+
+    /* Each goes to the least loaded core; note when each root is done */
+    if (cores > n) cores = n;
+    double load[ 32 + MAX_K ] = { 0 };
+    double root_done[ 32 ];
+    double fors_done = 0, makespan = 0;
+    for (i = 0; i < n; i++) {
+        unsigned c = 0;
+        for (j = 1; j < cores; j++) {
+            if (load[j] < load[c]) c = j;
+        }
+        load[c] += task[i].cost;
+        if (load[c] > makespan) makespan = load[c];
+        if (task[i].layer < 0) {
+            if (load[c] > fors_done) fors_done = load[c];
+        } else {
+            root_done[ task[i].layer ] = load[c];
+        }
+    }
+
+    /* And the chain of WOTS signatures, up from the FORS public key */
+    double chain = fors_done + t_fors + wots_sign;
+    for (i = t->d - 1; i-- > 0; ) {
+        if (root_done[i+1] > chain) chain = root_done[i+1];
+        chain += wots_sign;
+    }
+    return chain > makespan ? chain : makespan;
+}
+
+/*
+ * How many of the top layers of the hypertree we cache, in cache_bytes of
+ * memory.  The signer picks a random hypertree leaf each time, so caching
+ * a layer means caching every tree in it (the top one has one tree, the
+ * next 2^h_top, and so on), each of which is 2^(h'+1)-1 nodes (where h'
+ * is the height of the trees in that layer).  Once a layer is cached, the
+ * WOTS signatures of the layer above it (of its roots) never change, so
+ * we keep those too, wd hashes for each of its trees.
+ *
+ * We stop at the first layer with num_sig or more height above it.  That
+ * layer has at least 2^num_sig trees, so we expect to rebuild it on every
+ * signature anyway, and caching it would cost more than not
+ */
+static unsigned cached_layers( double cache_bytes, const struct hypertree *t,
+                               unsigned hash_size, unsigned wd,
+                               unsigned num_sig ) {
+    double used = 0;
+    unsigned i, above = 0;
+    for (i = 0; i < t->d; i++) {
+        unsigned h_tree = layer_height( t, i );
+        if (above >= num_sig) break;
+        used += ldexp( (ldexp( 2, h_tree ) - 1 + (i > 0 ? wd : 0)) *
+                                               hash_size, above );
+        if (used > cache_bytes) break;
+        above += h_tree;
+    }
+    return i;
+}
+
+/*
+ * The per-signature cost of the hypertree, when the top layers are
+ * cached.  We spread the cost of building a cached layer over the 2^n
+ * signatures we expect to make (a Merkle tree h' high costs
+ * leaf * 2^h' - node).  Only the bottom cached layer needs a WOTS
+ * signature each time; the root it signs is in a layer we don't cache
+ * (or is the FORS public key), and the ones above it sign cached roots
+ */
+static double cached_hypertree( unsigned layers, const struct hypertree *t,
+                                double leaf, double node,
+                                double wots_sign, unsigned num_sig ) {
+    double cost = layers ? wots_sign : 0;
+    unsigned i, above = 0;
+    for (i = layers; i < t->d; i++) {
+        cost += ldexp( leaf, layer_height( t, i ) ) - node;
+    }
+    for (i = 0; i < layers; i++) {
+        unsigned h_tree = layer_height( t, i );
+        cost += ldexp( ldexp( leaf, h_tree ) - node,
+                       (int)above - (int)num_sig );
+        above += h_tree;
+    }
+    return cost;
+}
+
+/*
+ * The peak memory (in bytes) of a signer that uses treehash (which keeps a
+ * stack of one node per level) to build each tree, one tree at a time:
+ * - The signature it's building (it is handed back in one piece)
+ * - The stack for the (tallest, h_tree high) Merkle tree, and the wd chain
+ *   heads of the leaf it is computing; or the stack for the tallest FORS
+ *   tree, whichever is more
+ * - The private key (SK.seed, SK.prf, PK.seed, PK.root)
+ */
+static unsigned peak_memory( unsigned hash_size, unsigned h, unsigned d,
+                             unsigned h_tree, unsigned wd, unsigned a,
+                             unsigned k, unsigned k_tall ) {
+    unsigned sig_size = sig_bytes( hash_size, h, d, wd, a, k, k_tall );
+    unsigned merkle = (h_tree + 1) + wd;
+    unsigned fors = a + 1 + (k_tall != 0);
+    return sig_size + hash_size * (merkle > fors ? merkle : fors) +
+           4 * hash_size;
+}
+
+/*
+ * The fewest FORS trees (between k_first and k_last) with which the
+ * hypertree height h and FORS height a are still at sec_level after 2^m
+ * signatures; 0 if even k_last doesn't make it.  More trees never hurts,
+ * so we can binary search.  bound[] is what we've learnt from earlier
+ * calls (with the same m, h, a and sec_level): bound[0] trees aren't
+ * enough, and bound[1] trees are (if it's not 0)
+ */
+static unsigned fewest_trees( double m, unsigned h, unsigned a,
+                              unsigned k_first, unsigned k_last,
+                              double sec_level, unsigned char *bound ) {
+    if (k_first > k_last || bound[0] >= k_last) return 0;
+    if (bound[1] && bound[1] <= k_first) return k_first;
+    if (k_first <= bound[0]) k_first = bound[0] + 1;
+    if (bound[1] && bound[1] <= k_last) {
+        k_last = bound[1];
+    } else if (check_sec_level( m, h, a, k_last, sec_level )) {
+        bound[1] = k_last;
+    } else {
+        bound[0] = k_last;
+        return 0;
+    }
+    while (k_first < k_last) {
+        unsigned mid = (k_first + k_last) / 2;
+        if (check_sec_level( m, h, a, mid, sec_level )) {
+            k_last = bound[1] = mid;
+        } else {
+            k_first = mid + 1;
+            bound[0] = mid;
+        }
+    }
+    return k_last;
+}
+
+/*
+ * With forsmix=1, the fewest of the k FORS trees that have to be a+1 high
+ * (rather than a) for h, a and k to be at sec_level after 2^m signatures,
+ * for each k from k_top down to k_first (where k_top trees, all a high,
+ * aren't enough).  Adding a tree never hurts, so that fewest only goes up
+ * as k goes down: it is a staircase, and we walk down it from k_top, with
+ * one evaluation per step down and one per step up.  We stop at the first k
+ * for which even k-1 taller trees aren't enough (fewer trees won't be either)
+ * and return the k above it.  fewest[k] is what we found, plus one (so 0 is
+ * not known yet; it is computed the same way for every hypertree with this h)
+ */
+static unsigned fewest_tall( double m, unsigned h, unsigned a,
+                             unsigned k_first, unsigned k_top,
+                             double sec_level, unsigned char *fewest,
+                             unsigned long long *evals ) {
+    unsigned k, k_tall = 1;
+    for (k = k_top; k >= k_first; k--) {
+        if (fewest[k]) {
+            k_tall = fewest[k] - 1;
+        } else {
+            while (k_tall < k && !check_sec_level_mixed( m, h, a, k, k_tall,
+                                                         sec_level )) {
+                k_tall++;
+                (*evals)++;
+            }
+            if (k_tall < k) (*evals)++;
+            fewest[k] = k_tall + 1;
+        }
+        if (k_tall >= k) return k + 1;
+    }
+    return k_first;
+}
+
+/*
+ * The optional columns; we list each one only if we were asked to compute
+ * what goes in it
+ */
+enum { COL_SIGN_US, COL_VER_US, COL_SIGN_LANES, COL_VER_LANES,
+       COL_SIGN_LANES_US, COL_VER_LANES_US, COL_SIGN_CORES, COL_CACHED_LAYERS, COL_SIGN_CACHED, COL_KEYGEN,
+       COL_PEAK_MEM, COL_OBJECTIVE, NUM_COLUMN };
+static const struct extra_column {
+    const char *title, *unit;   /* The two lines of the Latex heading */
+    const char *json;           /* The name of the JSON field */
+    int latex_decimals;         /* How many decimal places we list */
+    int json_decimals;
+} extra_column[ NUM_COLUMN ] = {
+    { "sign",   "$\\mu$s", "sign_us",    0, 1 },
+    { "verify", "$\\mu$s", "ver_us",     1, 1 },
+    { "sign",   "lanes",   "sign_lanes", 0, 0 },
+    { "verify", "lanes",   "ver_lanes",  1, 1 },
+    { "sign",   "lanes $\\mu$s", "sign_lanes_us", 0, 1 },
+    { "verify", "lanes $\\mu$s", "ver_lanes_us",  1, 1 },
+    { "sign",   "cores",   "sign_cores", 0, 0 },
+    { "cached", "layers",  "cached_layers", 0, 0 },
+    { "sign",   "amort.",  "sign_cached", 0, 0 },
+    { "keygen", "time",    "keygen_time", 0, 0 },
+    { "peak",   "mem",     "peak_mem",   0, 0 },
+    { "weighted", "cost",  "objective",  1, 1 },
+};
+
+static int column_listed( const struct search_params *params, int col ) {
+    switch (col) {
+    case COL_SIGN_US: case COL_VER_US:       return params->predict;
+    case COL_SIGN_LANES: case COL_VER_LANES: return params->lanes != 0;
+    case COL_SIGN_LANES_US: case COL_VER_LANES_US:
+                             return params->predict && params->lanes != 0;
+    case COL_SIGN_CORES:                     return params->cores != 0;
+    case COL_CACHED_LAYERS: case COL_SIGN_CACHED:
+                                             return params->cache_mb != 0;
+    case COL_KEYGEN:                         return params->keygen_op != 0;
+    case COL_PEAK_MEM:                       return params->mem_bytes != 0;
+    case COL_OBJECTIVE:      return params->objective == OBJECTIVE_WEIGHTED;
+    default:                                 return 0;
+    }
+}
+
+static double column_value( const struct parameter_set *p, int col ) {
+    switch (col) {
+    case COL_SIGN_US:    return p->sign_us;
+    case COL_VER_US:     return p->ver_us;
+    case COL_SIGN_LANES: return p->sign_lanes;
+    case COL_VER_LANES:  return p->ver_lanes;
+    case COL_SIGN_LANES_US: return p->sign_lanes_us;
+    case COL_VER_LANES_US: return p->ver_lanes_us;
+    case COL_SIGN_CORES: return p->sign_cores;
+    case COL_CACHED_LAYERS: return p->cached_layers;
+    case COL_SIGN_CACHED: return p->sign_cached;
+    case COL_KEYGEN:     return p->keygen_time;
+    case COL_PEAK_MEM:   return p->peak_mem;
+    case COL_OBJECTIVE:  return objective( p );
+    default:             return 0;
+    }
+}
+
+/*
+ * Print the start of the table, in the format that can be pasted directly
+ * into the Latex document
+ */
+static void print_latex_header( const struct search_params *params ) {
+    int col;
+    printf( "\\begin{longtable}{c|c|c|c|c|c|c|c|c|c|c|c|c|c|c|c|c" );
+    for (col = 0; col < NUM_COLUMN; col++) {
+        if (column_listed( params, col )) printf( "|c" );
+    }
+    printf( "}\n" );
+    printf( "      &     &     &     &      &     &     &        &     & sec  &  pk   &  sig  & \\\% & sign & verify & sigs at & overuse " );
+    for (col = 0; col < NUM_COLUMN; col++) {
+        if (column_listed( params, col )) {
+            printf( "& %-8s ", extra_column[col].title );
+        }
+    }
+    printf( "\\\\\n" );
+    printf( "   ID & $n$ & $h$ & $d$ & $h'$ & $a$ & $k$ & $lg_w$ & $m$ & cat. & bytes & bytes & size & time & time   & level %d & safety ", params->test_sec_level );
+    for (col = 0; col < NUM_COLUMN; col++) {
+        if (column_listed( params, col )) {
+            printf( "& %-8s ", extra_column[col].unit );
+        }
+    }
+    printf( "\\\\\n" );
+#if 0
+    printf( "   ID & H  &  D &  A &  K &  W  &  SigSize & Sign Time & Verify Time & Sigs/level %d \\\\\n", params->test_sec_level );
+#endif
+    printf( "  \\hline \\endhead\n" );
+}
+
+/*
+ * The heights of the Merkle trees, for the h' column: just the one height if
+ * they're all the same; otherwise the heights from the top down, with a run
+ * of n trees h high written hxn (so 9,5x2,6 is a top tree 9 high, two 5
+ * high, and a 6 high one at the bottom)
+ */
+static const char *merkle_heights( const struct parameter_set *p, char *buf ) {
+    struct hypertree t = shape_of( p );
+    if (is_uniform( &t )) {
+        sprintf( buf, "%u", t.base );
+        return buf;
+    }
+    int len = sprintf( buf, "%u", t.top );
+    unsigned n_base = t.d - 1 - t.tall;
+    if (n_base == 1) len += sprintf( buf+len, ",%u", t.base );
+    else if (n_base) len += sprintf( buf+len, ",%ux%u", t.base, n_base );
+    if (t.tall == 1) len += sprintf( buf+len, ",%u", t.base+1 );
+    else if (t.tall) len += sprintf( buf+len, ",%ux%u", t.base+1, t.tall );
+    return buf;
+}
+
+/*
+ * The heights of the FORS trees, for the a column, in the same form: with
+ * forsmix=1, 9x14,10x3 is 14 trees 9 high and 3 that are 10 high
+ */
+static const char *fors_heights( const struct parameter_set *p, char *buf ) {
+    unsigned k_short = p->k - p->k_tall;
+    if (p->k_tall == 0) {
+        sprintf( buf, "%u", p->a );
+        return buf;
+    }
+    int len = k_short == 1 ? sprintf( buf, "%u", p->a ) :
+                             sprintf( buf, "%ux%u", p->a, k_short );
+    if (p->k_tall == 1) sprintf( buf+len, ",%u", p->a+1 );
+    else sprintf( buf+len, ",%ux%u", p->a+1, p->k_tall );
+    return buf;
+}
+
+/*
+ * Print a single parameter set as a row of the Latex table
+ */
+static void print_latex_row( const struct search_params *params,
+                             const struct parameter_set *p, int count,
+                             unsigned smallest_sig ) {
+    int sec_level = params->sec_level;
+    char *label = params->label;
+    int overuse = p->overuse;
+
+    if (label) {
+        printf( "  %s-", label );
+        int k = strlen( label ) + 1 + printf( "%d", count );
+        for (; k<4; k++) printf( " " );
+        printf( "& " );
+    } else {
+        printf( "  %4d & ", count );
+    } 
+//	int delta_overuse = overuse - smallest_overuse;
+    char heights[100], fors[100];
+    printf( "%2d & %3d & %2d & %2s & %2s & %2d &   %d  & %2d &    %d     &     %d   & %  8d  & %d\\\% & % 9d & % 11d & %d.%02d & %u",
+	         sec_level/8,
+                       p->h, p->d, merkle_heights( p, heights ), fors_heights( p, fors ), p->k, ilog2(p->w), digest_bytes(p),
+		       (sec_level/64)*2 - 3, 2*(sec_level/8),
+		                           p->sig_size, 100*p->sig_size / smallest_sig, p->sig_time,
+                                                               p->ver_time,
+                   overuse/100, overuse % 100, overuse_safety( p, params->num_sig ) );
+    int col;
+    for (col = 0; col < NUM_COLUMN; col++) {
+        if (column_listed( params, col )) {
+            printf( "  & %8.*f", extra_column[col].latex_decimals,
+                    column_value( p, col ) );
+        }
+    }
+    printf( " \\\\\n" );
+#if 0
+    printf( "%2d & %2d & %2d & %2d & %3d & % 8d & % 9d & % 11d & %d.%02d \\\\\n",
+                 p->h, p->d,  p->a,p->k, p->w,   p->sig_size,
+                                                        p->sig_time,
+                                                               p->ver_time,
+                   overuse/100, overuse % 100 );
+#endif
+}
+
+/*
+ * Write a single parameter set as a JSON object (on a line by itself)
+ * curve is the name of the file with its overuse curve (if any)
+ */
+static void write_jsonl_row( struct writer *out,
+                             const struct search_params *params,
+                             const struct parameter_set *p, int count,
+                             const char *curve ) {
+    int sec_level = params->sec_level;
+
+    write_str( out, "{\"id\":" );
+    if (params->label) {
+        char id[100];
+        sprintf( id, "%.80s-%d", params->label, count );
+        write_json_str( out, id );
+    } else {
+        write_uint( out, count );
+    }
+    write_str( out, ",\"n\":" );        write_uint( out, sec_level/8 );
+    write_str( out, ",\"h\":" );        write_uint( out, p->h );
+    write_str( out, ",\"d\":" );        write_uint( out, p->d );
+    struct hypertree t = shape_of( p );
+    write_str( out, ",\"h_merkle\":" );
+    if (is_uniform( &t )) {
+        write_uint( out, t.base );
+    } else {
+        /* With mixed=1, the heights are listed from the top down */
+        unsigned i;
+        write_str( out, "null,\"layers\":[" );
+        for (i = 0; i < t.d; i++) {
+            if (i) write_str( out, "," );
+            write_uint( out, layer_height( &t, i ) );
+        }
+        write_str( out, "]" );
+    }
+    write_str( out, ",\"a\":" );        write_uint( out, p->a );
+    write_str( out, ",\"k\":" );        write_uint( out, p->k );
+    if (p->k_tall) {
+        /* With forsmix=1, this many of the k trees are a+1 high */
+        write_str( out, ",\"k_tall\":" ); write_uint( out, p->k_tall );
+    }
+    write_str( out, ",\"w\":" );        write_uint( out, p->w );
+    write_str( out, ",\"m\":" );        write_uint( out, digest_bytes(p) );
+    write_str( out, ",\"sec_cat\":" );  write_uint( out, (sec_level/64)*2 - 3 );
+    write_str( out, ",\"pk_size\":" );  write_uint( out, 2*(sec_level/8) );
+    write_str( out, ",\"sig_size\":" ); write_uint( out, p->sig_size );
+    write_str( out, ",\"sig_time\":" ); write_uint( out, p->sig_time );
+    write_str( out, ",\"ver_time\":" ); write_uint( out, p->ver_time );
+    write_str( out, ",\"overuse\":" );  write_fixed( out, p->overuse, 2 );
+    write_str( out, ",\"overuse_safety\":" );
+    write_uint( out, overuse_safety( p, params->num_sig ) );
+    int col;
+    for (col = 0; col < NUM_COLUMN; col++) {
+        if (column_listed( params, col )) {
+            int decimals = extra_column[col].json_decimals;
+            write_str( out, ",\"" );
+            write_str( out, extra_column[col].json );
+            write_str( out, "\":" );
+            write_fixed( out, llround( pow( 10, decimals ) *
+                                       column_value( p, col ) ), decimals );
+        }
+    }
+    write_str( out, ",\"curve\":" );
+    if (curve) {
+        write_json_str( out, curve );
+    } else {
+        write_str( out, "null" );
+    }
+    write_str( out, "}\n" );
+}
 
-    /* If equal, the smallest sign_time wins */
-    if (a->sig_time < b->sig_time) return  1;
-    if (a->sig_time > b->sig_time) return -1;
+/*
+ * The points of the overuse curve compute_overuse_curve most recently
+ * computed
+ */
+static double *curve_x, *curve_y;
+static unsigned curve_max;
 
-    /* If equal, the smallest verify_time wins */
-    if (a->ver_time < b->ver_time) return  1;
-    if (a->ver_time > b->ver_time) return -1;
+/*
+ * Add a point to the overuse curve we're building; returns 0 if we ran out
+ * of memory
+ */
+static int add_curve_point( unsigned *count, double x, double y ) {
+    if (*count == curve_max) {
+        unsigned new_max = curve_max ? 2*curve_max : 1024;
+        double *nx = realloc( curve_x, new_max * sizeof *nx );
+        if (nx) curve_x = nx;
+        double *ny = realloc( curve_y, new_max * sizeof *ny );
+        if (ny) curve_y = ny;
+        if (!nx || !ny) return 0;
+        curve_max = new_max;
+    }
+    curve_x[*count] = x;
+    curve_y[*count] = y;
+    (*count)++;
+    return 1;
+}
 
-    /* These two are identical as far as we can tell */
-    return 0;
+/*
+ * The value of the overuse curve after 2^(x/100) signatures
+ */
+static double curve_value( const struct search_params *params,
+                           const struct parameter_set *p, unsigned x ) {
+    double y = compute_sec_level_mixed(x / 100.0, p->h, p->a, p->k, p->k_tall);
+    if (y > params->sec_level) y = params->sec_level;
+    return y;
 }
 
 /*
- * This takes two lists of parameter sets (both in 'best first' order), and
- * merges them into a single list (in 'best first' order
+ * A segment of an adaptively sampled curve, between two points we've
+ * evaluated (x0 and x1, in hundredths); we've also evaluated the midpoint
+ * xm, and err is how far that is from the straight line between the ends
  */
-static struct parameter_set *my_merge( struct parameter_set *a, struct parameter_set *b ) {
-    struct parameter_set *list = 0;
-    struct parameter_set **tail = &list;
+struct curve_segment {
+    unsigned x0, x1, xm;
+    double y0, y1, ym;
+    double err;
+};
 
-    while (a && b) {
-        struct parameter_set *p;
-        if (my_compare( a, b ) >= 0) {
-            p = a;
-            a = a->link;
-        } else {
-            p = b;
-            b = b->link;
-        }
-        *tail = p;
-        tail = &p->link;
+static void make_segment( const struct search_params *params,
+                          const struct parameter_set *p,
+                          struct curve_segment *seg,
+                          unsigned x0, double y0, unsigned x1, double y1 ) {
+    seg->x0 = x0; seg->y0 = y0;
+    seg->x1 = x1; seg->y1 = y1;
+    if (x1 - x0 < 2) {
+        seg->err = 0;   /* Nothing between the ends; can't refine */
+        return;
     }
-    if (a) {
-        *tail = a;
-    } else {
-        *tail = b;
+    seg->xm = (x0 + x1) / 2;
+    seg->ym = curve_value( params, p, seg->xm );
+    double line = y0 + (y1 - y0) * (seg->xm - x0) / (x1 - x0);
+    seg->err = fabs( seg->ym - line );
+}
+
+/* Maintain a max-heap of segments, by err */
+static void push_segment( struct curve_segment *heap, unsigned *n,
+                          const struct curve_segment *seg ) {
+    unsigned i = (*n)++;
+    while (i > 0 && heap[(i-1)/2].err < seg->err) {
+        heap[i] = heap[(i-1)/2];
+        i = (i-1)/2;
     }
-    return list;
+    heap[i] = *seg;
 }
 
-static int ilog2( unsigned n ) {
-    int i;
-    for (i=0; n>1; i++, n >>= 1) {
-	;
+static void pop_segment( struct curve_segment *heap, unsigned *n,
+                         struct curve_segment *seg ) {
+    *seg = heap[0];
+    struct curve_segment last = heap[--*n];
+    unsigned i = 0;
+    for (;;) {
+        unsigned c = 2*i + 1;
+        if (c >= *n) break;
+        if (c+1 < *n && heap[c+1].err > heap[c].err) c++;
+        if (heap[c].err <= last.err) break;
+        heap[i] = heap[c];
+        i = c;
     }
-    return i;
+    if (*n) heap[i] = last;
+}
+
+static int compare_curve_x( const void *a, const void *b ) {
+    unsigned i = *(const unsigned *)a, j = *(const unsigned *)b;
+    return (curve_x[i] > curve_x[j]) - (curve_x[i] < curve_x[j]);
 }
 
 /*
- * This sorts the list of parameter sets into 'best first' order
- * It uses a merge sort
+ * Compute the overuse curve adaptively.  We start with a point at each
+ * integer number of signatures (log2), and then repeatedly split the
+ * segment which is the furthest from a straight line, until all of them are
+ * within params->curve_tol bits, or we hit params->curve_pts points.  We
+ * only use x values on the 0.01 grid, so the points are a subset of the ones
+ * the fixed sampling gives
  */
-static struct parameter_set *my_sort( struct parameter_set *list ) {
-#define NUM_BIN 20    /* This routine works even if we get more than */
-                      /* 2^20 parameter sets, it just goes slower */
-    struct parameter_set *bins[ NUM_BIN ] = { 0 }; /* bin[i] is either */
-                      /* NULL or a list of precisely 2^i parameter sets in */
-                      /* best-first order (except for i==19; we use that */
-                      /* as an overflow if we get more than 2^20) */
-
-    while (list) {
-        /* Extract the next time in the input list; make that a list with */
-        /* a single item */
-        struct parameter_set *p = list;
-        list = p->link;
-        p->link = 0;
+static unsigned compute_adaptive_curve( const struct search_params *params,
+                                        const struct parameter_set *p ) {
+    unsigned x_first = 100*(params->num_sig-1);
+    unsigned x_limit = 100*(params->max_s+10);
+    unsigned max_points = params->curve_pts ? (unsigned)params->curve_pts
+                                            : UINT_MAX;
+    unsigned count = 0;
 
-        /* Ripple-add that to the lists in bin */
-        int i;
-        for (i=0; i<NUM_BIN; i++) {
-            /* p is a sorted list of 2^i items */
+    if (x_first >= x_limit) return 0;
+    double y_first = curve_value( params, p, x_first );
+    if (y_first < 10) return 0;
 
-            if (!bins[i]) {
-                /* That bin is empty; insert it onto the list */
-                bins[i] = p;
-                break;
+    /*
+     * Seed the curve with the integer points (log2 of the number of
+     * signatures), up until the security level drops to below '10 bits'
+     * (or we hit the end)
+     */
+    unsigned x_last = x_first;
+    double y_last = y_first;
+    add_curve_point( &count, x_first / 100.0, y_first );
+    for (;;) {
+        unsigned x = x_last + 100 < x_limit ? x_last + 100 : x_limit - 1;
+        if (x == x_last) break;
+        double y = curve_value( params, p, x );
+        if (y < 10) {
+            /*
+             * The end is somewhere in here.  The security level only goes
+             * down as we generate more signatures, so we can binary search
+             * for it
+             */
+            unsigned lo = x_last, hi = x;   /* y(lo) >= 10, y(hi) < 10 */
+            while (hi - lo > 1) {
+                unsigned mid = (lo + hi) / 2;
+                y = curve_value( params, p, mid );
+                if (y >= 10) {
+                    lo = mid; y_last = y;
+                } else {
+                    hi = mid;
+                }
             }
-
-            /* That bin also has a list; merge them (and empty the bin) */
-            p = my_merge( bins[i], p );
-            bins[i] = 0;
-            /* p is a sorted list of 2^{i+1} items */
+            if (lo != x_last) {
+                add_curve_point( &count, lo / 100.0, y_last );
+                x_last = lo;
+            }
+            break;
         }
+        add_curve_point( &count, x / 100.0, y );
+        x_last = x; y_last = y;
+    }
 
-        /* If we ran out of bins, store the list in the overflow bin */
-        if (i == NUM_BIN) {
-            bins[NUM_BIN-1] = p;
+    /* Make segments between those points, to refine */
+    unsigned num_seed = count;
+    unsigned max_splits = x_last - x_first + 1;   /* Each split uses up */
+                                                  /* a grid point */
+    if (max_splits > max_points) max_splits = max_points;
+    struct curve_segment *heap = malloc( (num_seed + max_splits) * sizeof *heap );
+    if (!heap) return count;
+    unsigned heap_n = 0, i;
+    for (i = 1; i < num_seed; i++) {
+        struct curve_segment seg;
+        make_segment( params, p, &seg,
+                      (unsigned)(100*curve_x[i-1] + 0.5), curve_y[i-1],
+                      (unsigned)(100*curve_x[i] + 0.5), curve_y[i] );
+        push_segment( heap, &heap_n, &seg );
+    }
+
+    /* Now refine the worst segments */
+    while (heap_n > 0 && count < max_points &&
+                                      heap[0].err > params->curve_tol) {
+        struct curve_segment seg, left, right;
+        pop_segment( heap, &heap_n, &seg );
+        if (!add_curve_point( &count, seg.xm / 100.0, seg.ym )) break;
+        make_segment( params, p, &left, seg.x0, seg.y0, seg.xm, seg.ym );
+        make_segment( params, p, &right, seg.xm, seg.ym, seg.x1, seg.y1 );
+        push_segment( heap, &heap_n, &left );
+        push_segment( heap, &heap_n, &right );
+    }
+    free( heap );
+
+    /* And put the points into order */
+    unsigned *order = malloc( count * sizeof *order );
+    double *sorted = malloc( 2 * count * sizeof *sorted );
+    if (order && sorted) {
+        for (i = 0; i < count; i++) order[i] = i;
+        qsort( order, count, sizeof *order, compare_curve_x );
+        for (i = 0; i < count; i++) {
+            sorted[i] = curve_x[ order[i] ];
+            sorted[count + i] = curve_y[ order[i] ];
         }
+        memcpy( curve_x, sorted, count * sizeof *sorted );
+        memcpy( curve_y, sorted + count, count * sizeof *sorted );
     }
+    free( order );
+    free( sorted );
+    return count;
+}
 
-    /*
-     * We sorted the entire input list into bins; combine the bins
-     */
-    struct parameter_set *p = 0;
-    for (int i=0; i<NUM_BIN; i++) {
-        p = my_merge( bins[i], p );
+/*
+ * Compute the overuse curve of a parameter set; that is, its security level
+ * at various numbers of signatures (from 2^(num_sig-1) up to 2^(max_s+10))
+ * The points are placed in curve_x, curve_y; this returns how many there are
+ */
+static unsigned compute_overuse_curve( const struct search_params *params,
+                                       const struct parameter_set *p ) {
+    if (params->curve_tol > 0) {
+        return compute_adaptive_curve( params, p );
     }
 
-    return p;
+    unsigned count = 0;
+    unsigned x;
+    for (x = 100*(params->num_sig-1); x < 100*(params->max_s+10); x++) {
+        double fx = x / 100.0;
+        double y = curve_value( params, p, x );
+        if (y < 10) break;  /* No reason to list where the security */
+                            /* level drops to below '10 bits' */
+        if (!add_curve_point( &count, fx, y )) break;
+    }
+    return count;
 }
 
 /*
- * Convert the given number into ASCII with commas inserted to make reading
- * large numbers easier
- * For example: commify(65536) yields "65,536"
- * This uses a static buffer, the string should be used before this is
- * called again; don't use it multiple times in the same printf
+ * Time the built-in SLH-DSA implementation with a parameter set, and report
+ * that next to what the model predicts
  */
-static char *commify( unsigned n ) {
-    static char buffer[100];
-    int z = 100;
-    buffer[--z] = 0;
-    while (n >= 1000) {
-        buffer[--z] = (n%10) + '0'; n /= 10;
-        buffer[--z] = (n%10) + '0'; n /= 10;
-        buffer[--z] = (n%10) + '0'; n /= 10;
-        buffer[--z] = ',';
+#define BENCH_SECONDS 0.2   /* Keep signing (and verifying) for this long */
+
+static double elapsed_us( const struct timespec *start ) {
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (now.tv_sec - start->tv_sec) * 1e6 +
+           (now.tv_nsec - start->tv_nsec) / 1e3;
+}
+
+static void benchmark_set( const struct search_params *params,
+                           const struct parameter_set *p, const char *id ) {
+    int hash = params->hash ? params->hash : HASH_SHA2;
+    unsigned n = (params->sec_level + 7) / 8;
+    static const unsigned char msg[ COST_MSG_BYTES ] = "Sample message to sign";
+
+    struct slh_key *key = slh_keygen( hash, n, p->h, p->d, p->a, p->k, p->w );
+    if (!key) {
+        fprintf( stderr, "%6s  (can't do this parameter set)\n", id );
+        return;
     }
-    while (n) {
-        buffer[--z] = (n%10) + '0'; n /= 10;
+    size_t sig_len = slh_sig_bytes( key );
+    unsigned char *sig = malloc( sig_len );
+    if (!sig) {
+        fprintf( stderr, "Get a real computer you cheapskate\n" );
+        slh_free( key );
+        return;
     }
-    return &buffer[z];
+
+    struct timespec start;
+    unsigned signs = 0, verifies = 0;
+    int ok = 1;
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    do {
+        slh_sign( key, sig, msg, sizeof msg );
+        signs++;
+    } while (elapsed_us( &start ) < 1e6 * BENCH_SECONDS);
+    double sign_us = elapsed_us( &start ) / signs;
+
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    do {
+        ok &= slh_verify( key, sig, msg, sizeof msg );
+        verifies++;
+    } while (elapsed_us( &start ) < 1e6 * BENCH_SECONDS);
+    double ver_us = elapsed_us( &start ) / verifies;
+
+    /* Make sure it's really working; a corrupted signature must fail */
+    sig[ sig_len / 2 ] ^= 1;
+    if (slh_verify( key, sig, msg, sizeof msg )) ok = 0;
+
+    fprintf( stderr, "%6s %11.0f %11.0f %6.2f %9.1f %10.1f %10.1f %6.2f %10.1f%s%s\n",
+             id, p->sign_us, sign_us, sign_us / p->sign_us, 1e6 / sign_us,
+             p->ver_us, ver_us, ver_us / p->ver_us, 1e6 / ver_us,
+             ok ? "" : "  VERIFY FAILED",
+             sig_len == p->sig_size ? "" : "  SIZE MISMATCH" );
+    free( sig );
+    slh_free( key );
 }
 
 /*
@@ -204,10 +1611,77 @@ static char *commify( unsigned n ) {
  *                overuse characteristics of a specific parameter set (which
  *                might not happen to be one of the 'best' parameter sets
  *                listed by default).
+ * format       - How to list the parameter sets; FORMAT_LATEX is the Latex
+ *                table, FORMAT_JSONL is one JSON object per line
+ * curves_file  - If provided, we write the overuse curves of all the listed
+ *                parameter sets into this one file (see curves.h), rather
+ *                than into per-set CSV files
+ * curve_tol, curve_pts - If curve_tol is provided, we sample the overuse
+ *                curves adaptively (to within curve_tol bits, and with no
+ *                more than curve_pts points), rather than every 0.01
+ * dump_file    - If provided, we also write every parameter set we find
+ *                that meets the security requirement (not just the ones we
+ *                list) into this file (see dump.h)
+ * hash         - What we count the sign and verify costs (and sign_op) in;
+ *                hashes (HASH_ABSTRACT), or the compression function calls
+ *                (HASH_SHA2) or permutations (HASH_SHAKE) they take
+ * predict      - If set, we also list the sign and verify times we predict
+ *                on this host (calibrate_host must have been called)
+ * sign_us      - If provided, the sign budget is this many (predicted)
+ *                microseconds, rather than sign_op
+ * bench        - If provided, we sign and verify with the first this many
+ *                parameter sets we list (with the built-in SLH-DSA), and
+ *                report the times next to the predicted ones (which needs
+ *                predict)
+ * lanes        - If provided, we also list the sign and verify costs of a
+ *                signer which does this many hashes at once (multi-buffer)
+ * cores        - If provided, we also list the sign latency of a signer
+ *                which builds the Merkle and FORS trees on this many cores
+ * cache_mb     - If provided, we also list the amortized sign cost of a
+ *                signer which caches as many of the top hypertree layers
+ *                as fit in this many MB (and are worth caching)
+ * keygen_op    - If provided, we consider only parameter sets whose key
+ *                generation (building the top Merkle tree) takes no more
+ *                than this many hashes, and list that cost
+ * mem_bytes    - If provided, we consider only parameter sets which can
+ *                sign in this many bytes of memory (see peak_memory), and
+ *                list that
+ * objective    - What we list parameter sets in order of; OBJECTIVE_SIZE is
+ *                the signature size, OBJECTIVE_WEIGHTED is w_byte times
+ *                that, plus w_sign times the sign cost, plus w_ver times
+ *                the verify cost (using the costs budget picks)
+ * rank         - What we list parameter sets in order of first; RANK_SIZE
+ *                is the objective, RANK_SIGN and RANK_VERIFY are the sign
+ *                and verify costs (and then the objective breaks ties)
+ * pareto       - If set, we list the Pareto frontier (see pareto_frontier),
+ *                in rank order, rather than the overuse improvements
+ * top          - If provided, we list just the best this many parameter
+ *                sets (in rank order, whatever their overuse), rather than
+ *                the overuse improvements; we keep only those as we go,
+ *                and don't look at what can't get in.  With pareto, it's
+ *                the first this many on the frontier
+ * max_sig      - If provided, we consider only parameter sets whose
+ *                signature is no more than this many bytes
+ * max_ver      - If provided, we consider only parameter sets which take
+ *                no more than this many hashes to verify
+ * stats        - If set, we report (to stderr) how many security level
+ *                evaluations the search made, and how many it avoided
+ * budget       - Which of those costs sign_op limits (and which we rank
+ *                equal sized parameter sets by); BUDGET_SERIAL is the one
+ *                hash at a time cost, BUDGET_LANES is the lanes one,
+ *                BUDGET_CORES is the cores one, and BUDGET_CACHED is the
+ *                cache_mb one
  */
-void do_search( int sec_level, unsigned num_sig,
-                unsigned test_sec_level, unsigned sign_op, int max_s,
-                char *label, int d_restrict, int h_restrict, int a_restrict ) {
+void do_search( const struct search_params *params ) {
+    int sec_level = params->sec_level;
+    unsigned num_sig = params->num_sig;
+    unsigned test_sec_level = params->test_sec_level;
+    unsigned sign_op = params->sign_op;
+    int max_s = params->max_s;
+    char *label = params->label;
+    int d_restrict = params->d_restrict;
+    int h_restrict = params->h_restrict;
+    int a_restrict = params->a_restrict;
     unsigned w, log_w;
 
     /*
@@ -232,6 +1706,123 @@ void do_search( int sec_level, unsigned num_sig,
     /* Compute the size of the hash (in bytes) based on the security level */
     unsigned hash_size = (sec_level + 7)/8;
 
+    /*
+     * What the individual hash operations cost (in compression function
+     * calls, or permutations, or just 1 with hash=abstract)
+     */
+    int hash = params->hash;
+    unsigned cost_prf = hash_op_cost( hash, OP_PRF, hash_size, 0 );
+    unsigned cost_f = hash_op_cost( hash, OP_F, hash_size, 0 );
+    unsigned cost_h = hash_op_cost( hash, OP_H, hash_size, 0 );
+    unsigned cost_prf_msg = hash_op_cost( hash, OP_PRF_MSG, hash_size, 0 );
+
+    /*
+     * And how long they take on this host (in microseconds), if we were
+     * asked to predict times.  If the sign budget is given as a time
+     * (sign_us), that's what we check it against
+     */
+    double time_prf = op_time( params, OP_PRF, hash_size, 0 );
+    double time_f = op_time( params, OP_F, hash_size, 0 );
+    double time_h = op_time( params, OP_H, hash_size, 0 );
+    double time_prf_msg = op_time( params, OP_PRF_MSG, hash_size, 0 );
+    double sign_us = params->sign_us;
+
+    /* And what a multi-buffer signer would need (in batches), and how */
+    /* long a batch of each takes, if we're predicting times for it */
+    unsigned lanes = params->lanes;
+    double lane_prf = op_lane_time( params, OP_PRF, hash_size, 0 );
+    double lane_f = op_lane_time( params, OP_F, hash_size, 0 );
+    double lane_h = op_lane_time( params, OP_H, hash_size, 0 );
+    int predict_lanes = params->predict && lanes;
+    unsigned cores = params->cores;
+    double cache_bytes = params->cache_mb * 1024 * 1024;
+    int mixed = params->mixed;
+    int forsmix = params->forsmix;
+    unsigned mem_bytes = params->mem_bytes;
+    int budget = params->budget;
+
+    /*
+     * Set up the ranking now, as we prune on it as we go (see below)
+     */
+    rank_budget = budget;
+    rank_objective = params->objective;
+    rank_keys = rank_order[ params->rank ];
+    weight_byte = params->w_byte;
+    weight_sign = params->w_sign;
+    weight_ver = params->w_ver;
+
+    /*
+     * We can tell during the search that some parameter sets will never be
+     * listed.  Once we've seen one which
+     * meets the max_s overuse level (with a bit of margin, as that's
+     * checked differently here than when we list), listing that w class
+     * stops there; so nothing that ranks later (by the first key) in that
+     * class (or in the ones it blocks) will be listed.  prune_at[] is that
+     * key, for each class.  We don't do that with dump=, which wants
+     * everything
+     */
+    double prune_at[3] = { HUGE_VAL, HUGE_VAL, HUGE_VAL };
+    int prune = max_s && !params->dump_file && !params->pareto &&
+                !params->top;
+
+    /*
+     * With top=, we keep the best ones in a heap, rather than on the lists
+     * If we rank by size, we also know the smallest signature anything
+     * further down the loops can have, and so whether it can get in (again,
+     * not with dump=)
+     */
+    struct top_heap heap = { 0, 0, 0 };
+    int use_heap = params->top && !params->pareto;
+    if (use_heap) {
+        heap.size = params->top;
+        heap.set = malloc( heap.size * sizeof *heap.set );
+        if (!heap.set) {
+            fprintf( stderr, "Get a real computer you cheapskate\n" );
+            return;
+        }
+    }
+    int by_size = params->objective == OBJECTIVE_SIZE &&
+                  params->rank == RANK_SIZE;
+    int top_prune = use_heap && by_size && !params->dump_file;
+
+    /*
+     * And when we rank by size, the size we prune at (and max_sig) tells
+     * us where to stop the d, a and k loops, before we evaluate anything.
+     * These count how much that (and the lower bound on k) saves
+     */
+    unsigned max_sig = params->max_sig;
+    unsigned max_ver = params->max_ver;
+    unsigned long long sec_evals = 0, evals_k_min = 0, evals_size = 0;
+    unsigned long long evals_ver = 0, evals_known = 0;
+    unsigned long long pruned_d = 0, pruned_a = 0;
+
+    /*
+     * More FORS trees never make it less secure, so all we need to know is
+     * the fewest that are secure enough; and as that depends on just h and
+     * a (not on w, or on how the hypertree is split into layers), we
+     * remember it.  For each h and a, secure_k is that fewest (0 if we
+     * haven't found it yet), and none below tried_k are secure enough.
+     * Similarly, overuse_k is what fewest_trees has learnt about the
+     * fewest that reach max_s, and (with forsmix=1) tall_k what
+     * fewest_tall has about the fewest taller trees each k needs
+     */
+    unsigned max_h = sec_level + 31;
+    unsigned char *secure_k = calloc( 4 * max_h * 30 +
+                                      (forsmix ? max_h * 30 * MAX_K : 0), 1 );
+    if (!secure_k) {
+        fprintf( stderr, "Get a real computer you cheapskate\n" );
+        return;
+    }
+    unsigned char *tried_k = secure_k + max_h * 30;
+    unsigned char *overuse_k = secure_k + 2 * max_h * 30;
+    unsigned char *tall_k = secure_k + 4 * max_h * 30;
+
+    struct dump_file *dump = 0;
+    if (params->dump_file) {
+        dump = dump_open( params->dump_file, sec_level, num_sig,
+                          test_sec_level, sign_op, params->hash );
+    }
+
     /*
      * Now, we'll go through the various possibilities of parameter sets
      * First, we step through the possible w values
@@ -239,15 +1830,19 @@ void do_search( int sec_level, unsigned num_sig,
     for (w = 4, log_w = 2; w <= 256; w <<= 1, log_w++) {
         /* Pick the list that we'll be inserting the parameter sets into */
         struct parameter_set **current_list;
+        int w_class;
         if (w == 16) {
-            current_list = &w16_q;
+            current_list = &w16_q; w_class = 0;
         } else if (w == 256 || w == 4) {
-            current_list = &w256_q;
+            current_list = &w256_q; w_class = 1;
         } else {
-            current_list = &wother_q;
+            current_list = &wother_q; w_class = 2;
         }
 
-        unsigned wd, cost_ots;
+        unsigned wd, cost_ots, cost_t_wots;
+        double time_ots, time_t_wots;
+        double lanes_walk = 0, lane_t_wots;
+        double wots_sign;
 
         /* Compute the number of Winternitz digits used */
         {
@@ -272,11 +1867,22 @@ void do_search( int sec_level, unsigned num_sig,
              * The cost of stepping through each chain (wd * (w-1))
              * The top-most hash combining the values (1)
              *
-             * Costing the top-most hash as one hash computation isn't
-             * precisely accurate; however it isn't that misleading (and the
-             * actual value depends on the hash function used)
+             * With hash=abstract, each of those costs 1, and so this is
+             * 1 + wd * w.  Otherwise, the top-most hash (which takes all wd
+             * chain heads as input) can cost rather more than the others
              */
-            cost_ots = 1 + wd * w;
+            cost_t_wots = hash_op_cost( hash, OP_T, hash_size, wd );
+            cost_ots = cost_prf * wd + cost_f * wd * (w-1) + cost_t_wots;
+            time_t_wots = op_time( params, OP_T, hash_size, wd );
+            time_ots = time_prf * wd + time_f * wd * (w-1) + time_t_wots;
+            lane_t_wots = op_lane_time( params, OP_T, hash_size, wd );
+
+            /* The cost of a WOTS signature (each chain goes half way, on */
+            /* average) */
+            wots_sign = cost_prf * wd + cost_f * wd * (w-1) / 2.0;
+
+            /* The F batches it takes to verify those chains */
+            if (lanes) lanes_walk = lanes_chain_walk( lanes, wd, w );
         }
 
         /*
@@ -286,124 +1892,628 @@ void do_search( int sec_level, unsigned num_sig,
         for (h_merkle = 2; h_merkle <= sec_level+20 && h_merkle < 32; h_merkle++) {
             if (h_restrict && h_merkle != h_restrict) continue;
             int h, d; /* h == hypertree height, d == number of Merkle levels */
-            unsigned node_tree = 1<<h_merkle;  /* The number of leaves of a single Merkle tree */
+            double merkle_leaf = (double)(cost_ots+cost_h);
+                                /* A Merkle tree costs this per leaf (less */
+                                /* cost_h, as the root isn't combined) */
 
             /*
-             * Now, step through the total number of Merkle tree layers
-             * We only consider hypertree heights that are reasonable:
-             * - If it exceeds the security level by more than 30, there are
-             *   likely to be cheaper options
-             * - If the height is less than 5 fewer than the number of
-             *   signatures we'll require, it's likely not going to meet our
-             *   security requirements
-             * - If it has 30 or more Merkle levels, the signature size is
-             *   likely to be unreasonable
+             * Key generation builds one Merkle tree (the top one); if
+             * that's over our limit, so is every taller one.  With mixed=1,
+             * the top tree can be one shorter than h_merkle
              */
-            for (h = h_merkle, d = 1 ; h <= sec_level+30; h += h_merkle, d++) {
-                if (d >= 30) break;
-                if (d_restrict && d != d_restrict) continue;
-                if (h < num_sig - 5) continue;
+            int raise_min = mixed && h_merkle > 2 ? -1 : 0;
+            if (params->keygen_op && ldexp( merkle_leaf, h_merkle + raise_min )
+                                         - cost_h > params->keygen_op) break;
 
-                /*
-                 * The number of hashes we'll need to build the Merkle trees
-                 * during a signing operation (which are:
-                 * - The cost of building all the one-time public keys:
-                 *     d * cost_ots * node_tree
-                 * - The cost of combining all the internal nodes of the Merkle
-                 *   trees:
-                 *     d * (node_tree-1)
-                 */
-                float cost_hypertree = d*((float)(cost_ots+1) * node_tree - 1);
+            /*
+             * The ways we arrange the layers (see struct hypertree): the top
+             * tree is h_merkle+raise high, and the bottom tall trees are
+             * h_merkle+1.  Without mixed=1, that's just the uniform one.
+             * With it, we don't bother with the ones that can't help:
+             * - Which order the lower trees are in doesn't change any of the
+             *   costs (unless they're cached), except that the digest length
+             *   depends on the bottom one; we take just the one with the
+             *   taller ones at the bottom (and work its digest out from that
+             *   shape), and so might miss one a compression call cheaper to
+             *   verify
+             * - If their heights differ by more than one, evening them out
+             *   makes signing cheaper, for the same size and security; so
+             *   at least one is h_merkle high, and none taller than h_merkle+1
+             *   (if they were all h_merkle+1, that's one for h_merkle+1)
+             * - The same goes for the top tree; except that it is built
+             *   during key generation, so it can be one shorter, and if it's
+             *   cached, it's cheap to make it taller (so we do, as long as
+             *   it fits in cache=)
+             */
+            struct { int raise; unsigned tall; } mix[ 32 * 28 ];
+            unsigned num_mix = 0, m;
+            int up, raise_max = mixed ? 31 - h_merkle : 0;
+            for (up = raise_min; up <= raise_max; up++) {
+                unsigned h_top = h_merkle + up;
+                if (up > 0 && (ldexp( 2, h_top ) - 1) * hash_size >
+                                                       cache_bytes) break;
+                if (params->keygen_op && ldexp( merkle_leaf, h_top ) - cost_h >
+                                                 params->keygen_op) break;
+                unsigned tall, tall_max = mixed && up >= 0 &&
+                                          h_merkle < 31 ? 27 : 0;
+                for (tall = 0; tall <= tall_max; tall++) {
+                    mix[num_mix].raise = up;
+                    mix[num_mix].tall = tall;
+                    num_mix++;
+                }
+            }
 
-                /*
-                 * If that cost exceeds our cost limit, we can stop at this h
-                 */
-                if (cost_hypertree >= sign_op) break; /* Step to the next */
-                                                      /* Merkle tree height */
+            for (m = 0; m < num_mix; m++) {
+                unsigned tall = mix[m].tall;
+                double keygen_time = ldexp( merkle_leaf, h_merkle + mix[m].raise )
+                                                                 - cost_h;
 
                 /*
-                 * Now, step through the various heights of FORS trees
-                 * We stop at FORS tree height 30 - that is likely to be
-                 * far too expensive
+                 * Now, step through the total number of Merkle tree layers
+                 * We only consider hypertree heights that are reasonable:
+                 * - If it exceeds the security level by more than 30, there are
+                 *   likely to be cheaper options
+                 * - If the height is less than 5 fewer than the number of
+                 *   signatures we'll require, it's likely not going to meet our
+                 *   security requirements
+                 * - If it has 30 or more Merkle levels, the signature size is
+                 *   likely to be unreasonable
                  */
-                unsigned a;
-                for (a=1; a<30; a++) {
-                    if (a_restrict && a != a_restrict) continue;
+                for (d = (mix[m].raise || tall) ? tall + 2 : 1,
+                     h = d * h_merkle + tall + mix[m].raise;
+                     h <= sec_level+30; h += h_merkle, d++) {
+                    if (d >= 30) break;
+                    if (d_restrict && d != d_restrict) continue;
+                    if (h < num_sig - 5) continue;
+                    struct hypertree shape = { h, d, h_merkle + mix[m].raise,
+                                               h_merkle, tall };
+
+                    /*
+                     * If even the smallest FORS makes the signature too big to
+                     * be listed, a larger d will too.  Likewise if it takes
+                     * too long to verify, or doesn't fit in memory.  These are
+                     * in order of how often they stop us
+                     */
+                    if (sig_bytes( hash_size, h, d, wd, 1, 1, 0 ) >
+                            listable_size( max_sig, &heap, top_prune,
+                                  by_size ? prune_at[w_class] : HUGE_VAL )) {
+                        pruned_d++;
+                        break;
+                    }
+                    unsigned ver_hypertree = d * (wd * w/2 * cost_f + cost_t_wots) +
+                                             h*cost_h;
+                    if (max_ver && ver_hypertree + cost_f + cost_h > max_ver) {
+                        pruned_d++;
+                        break;
+                    }
+                    if (mem_bytes && peak_memory( hash_size, h, d,
+                                 tallest_tree( &shape ), wd, 1, 1, 0 ) > mem_bytes) break;
 
                     /*
-                     * Cost of building a FORS tree, including:
-                     * The cost of converting the private seed into the
-                     *     private FORS value (1 << a)
-                     * The cost of converting the private FORS value into the
-                     *     public one (1 << a)
-                     * The cost of building the Merkle tree (1 << a) - 1
+                     * The number of hashes we'll need to build the Merkle trees
+                     * during a signing operation (which are:
+                     * - The cost of building all the one-time public keys:
+                     *     cost_ots * node_tree, for each tree
+                     * - The cost of combining all the internal nodes of the Merkle
+                     *   trees:
+                     *     node_tree-1, for each tree
+                     * (where node_tree is 2^(the height of that tree))
                      */
-                    unsigned cost_fors_tree = 3 * (1 << a) - 1;
+                    double tree_top = ldexp( merkle_leaf, shape.top ) - cost_h;
+                    double tree_cost = ldexp( merkle_leaf, h_merkle ) - cost_h;
+                    double tree_tall = ldexp( merkle_leaf, h_merkle+1 ) - cost_h;
+                    float cost_hypertree = layer_sum( &shape, (float)tree_top,
+                                              (float)tree_cost, (float)tree_tall );
+                    unsigned layers = cache_bytes ? cached_layers( cache_bytes,
+                                          &shape, hash_size, wd, num_sig ) : 0;
+                    double amort_hypertree = cache_bytes ? cached_hypertree(
+                                          layers, &shape, merkle_leaf, cost_h,
+                                          wots_sign, num_sig ) : 0;
+                    double time_leaf = time_ots + time_h;
+                    double time_hypertree = layer_sum( &shape,
+                                          ldexp( time_leaf, shape.top ) - time_h,
+                                          ldexp( time_leaf, h_merkle ) - time_h,
+                                          ldexp( time_leaf, h_merkle+1 ) - time_h );
+                    double lanes_hypertree = lanes ? layer_sum( &shape,
+                            lanes_merkle_tree( lanes, shape.top, wd, w, cost_prf,
+                                               cost_f, cost_t_wots, cost_h ),
+                            lanes_merkle_tree( lanes, h_merkle, wd, w, cost_prf,
+                                               cost_f, cost_t_wots, cost_h ),
+                            lanes_merkle_tree( lanes, h_merkle+1, wd, w, cost_prf,
+                                               cost_f, cost_t_wots, cost_h ) ) : 0;
+                    double time_lanes_hypertree = predict_lanes ? layer_sum( &shape,
+                            lanes_merkle_tree( lanes, shape.top, wd, w, lane_prf,
+                                               lane_f, lane_t_wots, lane_h ),
+                            lanes_merkle_tree( lanes, h_merkle, wd, w, lane_prf,
+                                               lane_f, lane_t_wots, lane_h ),
+                            lanes_merkle_tree( lanes, h_merkle+1, wd, w, lane_prf,
+                                               lane_f, lane_t_wots, lane_h ) ) : 0;
+
+                    /*
+                     * If that cost exceeds our cost limit, we can stop at this h
+                     */
+                    int over_budget;
+                    switch (budget) {
+                    case BUDGET_LANES:
+                        over_budget = lanes_hypertree >= sign_op; break;
+                    case BUDGET_CORES:
+                        over_budget = lpt_sign_latency( cores, &shape,
+                                          merkle_leaf, cost_h, 0, 0, 0, 0,
+                                          0, wots_sign ) >= sign_op;
+                        break;
+                    case BUDGET_CACHED:
+                        /* (the serial costs still need to fit in sig_time) */
+                        over_budget = amort_hypertree >= sign_op ||
+                                      cost_hypertree >= UINT_MAX / 2;
+                        break;
+                    default:
+                        over_budget = sign_us ? time_hypertree >= sign_us
+                                              : cost_hypertree >= sign_op;
+                        break;
+                    }
+                    if (over_budget) break; /* Step to the next Merkle tree */
+                                            /* height */
 
-                    unsigned k;
                     /*
-                     * And step through the various possible number of FORS
-                     * trees
+                     * Now, step through the various heights of FORS trees
+                     * We stop at FORS tree height 30 - that is likely to be
+                     * far too expensive
                      */
-                    for (k=1; k<MAX_K; k++) {
+                    unsigned a;
+                    for (a=1; a<30; a++) {
+                        if (a_restrict && a != (unsigned)a_restrict) continue;
+                        unsigned listable = listable_size( max_sig, &heap,
+                                  top_prune, by_size ? prune_at[w_class] : HUGE_VAL );
+                        if (sig_bytes( hash_size, h, d, wd, a, 1, 0 ) > listable) {
+                            pruned_a++;
+                            break;
+                        }
+                        unsigned ver_fors_tree = cost_f + a*cost_h;
+                        if (max_ver && ver_hypertree + ver_fors_tree > max_ver) {
+                            pruned_a++;
+                            break;
+                        }
+                        if (mem_bytes && peak_memory( hash_size, h, d,
+                                 tallest_tree( &shape ), wd, a, 1, 0 ) > mem_bytes) break;
+
+                        /*
+                         * Cost of building a FORS tree, including:
+                         * The cost of converting the private seed into the
+                         *     private FORS value (1 << a)
+                         * The cost of converting the private FORS value into the
+                         *     public one (1 << a)
+                         * The cost of building the Merkle tree (1 << a) - 1
+                         * (which is 3 * (1 << a) - 1 with hash=abstract)
+                         */
+                        unsigned cost_fors_tree = (cost_prf + cost_f + cost_h) * (1 << a) - cost_h;
+                        double time_fors_tree = (time_prf + time_f + time_h) * (1 << a) - time_h;
+
+                        /*
+                         * With forsmix=1, making one of the trees a+1 high
+                         * doubles its leaves, and so costs this much more
+                         * (we stop at 29 high, as with a)
+                         */
+                        int fors_tall = forsmix && a < 29;
+                        unsigned cost_taller = cost_fors_tree + cost_h;
+                        double time_taller = time_fors_tree + time_h;
+
+                        /*
+                         * We don't need to look at any that are too big to be
+                         * listed, or that take too long to verify.  Leaving out
+                         * the message hash and the combining of the FORS roots,
+                         * we can't take more than k_ver; those grow with k too,
+                         * so we then step down until they fit as well (which
+                         * is just a step or two).  We do that here, so that we
+                         * don't check the security of ones too slow to verify
+                         */
+                        unsigned k_size = (listable / hash_size - 1 -
+                                           d * wd - h) / (a+1) + 1;
+                        unsigned k_ver = max_ver ? (max_ver - ver_hypertree) /
+                                                   ver_fors_tree + 1 : MAX_K;
+                        if (k_ver > MAX_K) k_ver = MAX_K;
+                        while (max_ver && k_ver > 1) {
+                            struct parameter_set candidate = { .h = h, .d = d,
+                                            .a = a, .k = k_ver - 1,
+                                            .h_top = shape.top, .tall = tall };
+                            if (hash_op_cost( hash, OP_H_MSG, hash_size,
+                                              digest_bytes(&candidate) ) +
+                                (k_ver - 1) * ver_fors_tree +
+                                hash_op_cost( hash, OP_T, hash_size, k_ver - 1 ) +
+                                ver_hypertree <= max_ver) break;
+                            k_ver--;
+                        }
+                        unsigned k_cap = k_size < k_ver ? k_size : k_ver;
+
+                        unsigned k, k_limit;
                         /*
-                         * If the combined cost of building the Hypertree and
-                         * the FORS trees are more than our budget, we can
-                         * stop here
+                         * Find how many FORS trees we can afford; if the
+                         * combined cost of building the Hypertree and the FORS
+                         * trees are more than our budget, we can stop there.
+                         * We don't go past k_cap (unless we're counting what
+                         * that saves)
                          */
-                        if (cost_hypertree + k*cost_fors_tree > sign_op) break;
+                        for (k_limit=1; k_limit<MAX_K; k_limit++) {
+                            if (k_limit >= k_cap && !params->stats) break;
+                            switch (budget) {
+                            case BUDGET_LANES:
+                                over_budget = lanes_hypertree + lanes_fors( lanes,
+                                          a, k_limit, 0, cost_prf, cost_f, cost_h )
+                                                                      > sign_op;
+                                break;
+                            case BUDGET_CORES:
+                                over_budget = lpt_sign_latency( cores, &shape,
+                                              merkle_leaf, cost_h, k_limit,
+                                              cost_fors_tree, 0, 0,
+                                              0, wots_sign ) > sign_op;
+                                break;
+                            case BUDGET_CACHED:
+                                over_budget = amort_hypertree +
+                                        (double)k_limit*cost_fors_tree > sign_op;
+                                break;
+                            default:
+                                over_budget = sign_us ?
+                                      time_hypertree + k_limit*time_fors_tree > sign_us
+                                    : cost_hypertree + k_limit*cost_fors_tree > sign_op;
+                                break;
+                            }
+                            if (over_budget) break;
+
+                            /* And the memory limit */
+                            if (mem_bytes && peak_memory( hash_size, h, d,
+                                                tallest_tree( &shape ), wd, a,
+                                                k_limit, 0 ) > mem_bytes) break;
+                        }
 
-                        /* Check if it meets the security requirement */
-                        if (!check_sec_level( num_sig, h, a, k, sec_level )) {
-                            continue;
+                        if (k_cap < k_limit) {
+                            if (k_size < k_ver) evals_size += k_limit - k_cap;
+                            else evals_ver += k_limit - k_cap;
+                            k_limit = k_cap;
                         }
 
                         /*
-                         * This one checks out - add it to the list of
-                         * acceptable parameter sets that we've found
+                         * Nor at any with too few FORS trees to possibly be
+                         * secure
+                         */
+                        unsigned k_first = fors_k_min( sec_level, num_sig, h, a );
+                        if (k_first > k_limit) k_first = k_limit;
+                        evals_k_min += k_first - 1;
+
+                        /*
+                         * Check the FORS tree counts we haven't already
+                         * against the security requirement in one go, to
+                         * find the fewest that's enough
                          */
-                        struct parameter_set *p = malloc( sizeof *p );
-                        if (!p) {
-                            fprintf( stderr, "Get a real computer you cheapskate\n" );
-                            return;
+                        unsigned char *known = &secure_k[ h*30 + a ];
+                        unsigned char *tried = &tried_k[ h*30 + a ];
+                        if (*tried < k_first) *tried = k_first;
+                        if (!*known && *tried < k_limit) {
+                            unsigned char meets_sec[ MAX_K ];
+                            unsigned count = k_limit - *tried, i;
+                            check_sec_level_batch( num_sig, h, a, *tried,
+                                           count, sec_level, meets_sec );
+                            sec_evals += count;
+                            evals_known += k_limit - k_first - count;
+                            for (i = 0; i < count && !meets_sec[i]; i++)
+                                ;
+                            if (i < count) *known = *tried + i;
+                            *tried = k_limit;
+                        } else {
+                            evals_known += k_limit - k_first;
                         }
-                        p->h = h;
-                        p->d = d;
-                        p->a = a;
-                        p->k = k;
-                        p->w = w;
-                        p->sig_size = hash_size * (1 + k * (a+1) + d * (wd + h_merkle ) );
+                        if (*known > k_first) k_first = *known;
+                        else if (!*known) k_first = k_limit;
+
+                        /*
+                         * The fewest FORS trees that meet the max_s overuse
+                         * level (if we're pruning; we find that when we need
+                         * it, which is -1 until then)
+                         */
+                        int k_max_s = -1;
+
+                        /*
+                         * And step through the various possible number of FORS
+                         * trees
+                         */
                         /*
-                         * Sign time is:
-                         * - Time for PRF_msg evaluation (1)
-                         * - Time for H_msg evaluation (1)
-                         * - Time for the FORS (k trees at the cost we
-                         *   computed each, plus 1 for the hash to combine)
-                         * - Time to compute the hypertree (already computed)
+                         * With forsmix=1, fewer trees can be secure enough,
+                         * if enough of them are a+1 high; find the fewest
+                         * with which that works, and how many taller ones
+                         * each k between that and k_first needs
                          */
-                        p->sig_time = 3 + cost_hypertree + k*cost_fors_tree;
+                        unsigned char *fewest = &tall_k[ (h*30 + a) * MAX_K ];
+                        unsigned k_lo = k_first;
+                        if (fors_tall) {
+                            unsigned k_min = fors_k_min( sec_level, num_sig,
+                                                         h, a+1 );
+                            if (k_min < k_first) {
+                                k_lo = fewest_tall( num_sig, h, a, k_min,
+                                                    k_first - 1, sec_level,
+                                                    fewest, &sec_evals );
+                            }
+                        }
 
                         /*
-                         * Verify time is:
-                         * - Time for H_msg message hash (1)
-                         * - Time to walk up each FORS tree (a+1 each, k times)
-                         * - Time to combine the FORS roots together (1)
-                         * - For each Merkle tree (that is, d itmes):
-                         *   - Walk up (on average) half the Winternitz chain,
-                         *     for each Winternitz digit (wd times)
-                         *   - Compute the Winternitz heads together
-                         *   - Walk up the Merkle auth path (h_merkle)
+                         * And step through the various possible number of FORS
+                         * trees (and of those, how many are taller).  If one
+                         * with none taller is over a limit, so is everything
+                         * with more trees; otherwise, all we know is that so
+                         * is everything with more taller ones.  We go up to
+                         * a more taller ones than we need; a+1 more would be
+                         * the same size as another tree a high, which costs
+                         * far less to sign (for a little less overuse)
                          */
-                        p->ver_time = 1 + k * (a+1) + 1 + d * (wd * w/2 + 1 + h_merkle);
-                        p->link = *current_list;
-                        *current_list = p;
+                        for (k=k_lo; k<k_limit; k++) {
+                            unsigned k_tall = k < k_first ? fewest[k] - 1 : 0;
+                            unsigned tall_last = fors_tall ? k_tall + a : 0;
+                            if (tall_last >= k) tall_last = k - 1;
+                            for (; k_tall <= tall_last; k_tall++) {
+                                /*
+                                 * (k_limit took care of the budget, size
+                                 * and memory with none taller)
+                                 */
+                                if (k_tall) {
+                                    switch (budget) {
+                                    case BUDGET_LANES:
+                                        over_budget = lanes_hypertree +
+                                              lanes_fors( lanes, a, k, k_tall,
+                                                   cost_prf, cost_f, cost_h )
+                                                                  > sign_op;
+                                        break;
+                                    case BUDGET_CORES:
+                                        over_budget = lpt_sign_latency( cores,
+                                              &shape, merkle_leaf, cost_h, k,
+                                              cost_fors_tree, k_tall,
+                                              cost_fors_tree + cost_taller,
+                                              0, wots_sign ) > sign_op;
+                                        break;
+                                    case BUDGET_CACHED:
+                                        over_budget = amort_hypertree +
+                                              (double)k*cost_fors_tree +
+                                              (double)k_tall*cost_taller > sign_op;
+                                        break;
+                                    default:
+                                        over_budget = sign_us ?
+                                              time_hypertree + k*time_fors_tree +
+                                              k_tall*time_taller > sign_us
+                                            : cost_hypertree + k*cost_fors_tree +
+                                              (double)k_tall*cost_taller > sign_op;
+                                        break;
+                                    }
+                                    if (over_budget) break;
+                                    if (sig_bytes( hash_size, h, d, wd, a, k,
+                                                   k_tall ) > listable) break;
+                                    if (mem_bytes && peak_memory( hash_size, h,
+                                            d, tallest_tree( &shape ), wd, a, k,
+                                            k_tall ) > mem_bytes) break;
+                                }
+                                /*
+                                 * Check the verify time; if it's too long, it will
+                                 * be with more FORS trees (or taller ones) too.
+                                 * Verify time is:
+                                 * - Time for H_msg message hash (1)
+                                 * - Time to walk up each FORS tree (a+1 each, k times,
+                                 *   and one more for each taller one)
+                                 * - Time to combine the FORS roots together (1)
+                                 * - For each Merkle tree (that is, d itmes):
+                                 *   - Walk up (on average) half the Winternitz chain,
+                                 *     for each Winternitz digit (wd times)
+                                 *   - Compute the Winternitz heads together
+                                 *   - Walk up the Merkle auth path (the height of
+                                 *     that tree; h, over all of them)
+                                 */
+                                struct parameter_set candidate = { .h = h, .d = d,
+                                                .a = a, .k = k, .h_top = shape.top,
+                                                .tall = tall, .k_tall = k_tall };
+                                unsigned cost_h_msg = hash_op_cost( hash, OP_H_MSG,
+                                                hash_size, digest_bytes(&candidate) );
+                                unsigned cost_t_fors = hash_op_cost( hash, OP_T,
+                                                                     hash_size, k );
+                                unsigned ver_time = cost_h_msg + k * ver_fors_tree +
+                                                    k_tall * cost_h +
+                                                    cost_t_fors + ver_hypertree;
+                                if (max_ver && ver_time > max_ver) break;
+
+                                /*
+                                 * This one checks out - add it to the list of
+                                 * acceptable parameter sets that we've found
+                                 */
+                                struct parameter_set *p = malloc( sizeof *p );
+                                if (!p) {
+                                    fprintf( stderr, "Get a real computer you cheapskate\n" );
+                                    return;
+                                }
+                                p->h = h;
+                                p->d = d;
+                                p->a = a;
+                                p->k = k;
+                                p->k_tall = k_tall;
+                                p->w = w;
+                                p->h_top = shape.top;
+                                p->tall = tall;
+                                p->keygen_time = keygen_time;
+                                p->peak_mem = peak_memory( hash_size, h, d,
+                                                  tallest_tree( &shape ), wd, a, k,
+                                                  k_tall );
+                                p->sig_size = sig_bytes( hash_size, h, d, wd, a, k,
+                                                         k_tall );
+                                p->ver_time = ver_time;
+                                /*
+                                 * Sign time is:
+                                 * - Time for PRF_msg evaluation (1)
+                                 * - Time for H_msg evaluation (1)
+                                 * - Time for the FORS (k trees at the cost we
+                                 *   computed each, plus 1 for the hash to combine;
+                                 *   the taller ones cost cost_taller more)
+                                 * - Time to compute the hypertree (already computed)
+                                 */
+                                p->sig_time = (cost_prf_msg + cost_h_msg + cost_t_fors) +
+                                               cost_hypertree + k*cost_fors_tree +
+                                               k_tall*cost_taller;
+
+                                /* And the same, as predicted times */
+                                double time_h_msg = op_time( params, OP_H_MSG,
+                                                      hash_size, digest_bytes(p) );
+                                double time_t_fors = op_time( params, OP_T,
+                                                              hash_size, k );
+                                if (params->predict) {
+                                    p->sign_us = time_prf_msg + time_h_msg + time_t_fors +
+                                                 time_hypertree + k*time_fors_tree +
+                                                 k_tall*time_taller;
+                                    p->ver_us = time_h_msg + k * (time_f + a*time_h) +
+                                                k_tall*time_h +
+                                                time_t_fors + d * (wd * w/2 * time_f +
+                                                time_t_wots) + h*time_h;
+                                }
+
+                                /*
+                                 * And the same, for a multi-buffer signer.  It
+                                 * walks up the k FORS trees together; the message
+                                 * hashes and the T hashes have nothing to batch
+                                 * with
+                                 */
+                                if (lanes) {
+                                    p->sign_lanes = (cost_prf_msg + cost_h_msg + cost_t_fors) +
+                                                 lanes_hypertree + lanes_fors( lanes,
+                                                 a, k, k_tall, cost_prf, cost_f, cost_h );
+                                    p->ver_lanes = cost_h_msg + batches( k, lanes ) *
+                                                (cost_f + a*cost_h) +
+                                                batches( k_tall, lanes ) * cost_h +
+                                                cost_t_fors +
+                                                d * (lanes_walk * cost_f +
+                                                cost_t_wots) + h*cost_h;
+                                }
+
+                                /*
+                                 * And that, as predicted times; the batches
+                                 * take what the multi-buffer hashes do, and
+                                 * the hashes with nothing to batch with take
+                                 * what the single ones do
+                                 */
+                                if (predict_lanes) {
+                                    p->sign_lanes_us = time_prf_msg + time_h_msg +
+                                                 time_t_fors + time_lanes_hypertree +
+                                                 lanes_fors( lanes, a, k, k_tall,
+                                                             lane_prf, lane_f, lane_h );
+                                    p->ver_lanes_us = time_h_msg + batches( k, lanes ) *
+                                                (lane_f + a*lane_h) +
+                                                batches( k_tall, lanes ) * lane_h +
+                                                time_t_fors +
+                                                d * (lanes_walk * lane_f +
+                                                time_t_wots) + h*time_h;
+                                }
+
+                                /*
+                                 * And the latency on cores cores; the message
+                                 * hashes have to come before the trees (they pick
+                                 * which trees)
+                                 */
+                                if (cores) {
+                                    p->sign_cores = (cost_prf_msg + cost_h_msg) +
+                                               lpt_sign_latency( cores, &shape,
+                                                   merkle_leaf, cost_h,
+                                                   k, cost_fors_tree, k_tall,
+                                                   cost_fors_tree + cost_taller,
+                                                   cost_t_fors, wots_sign );
+                                }
+
+                                /* And the amortized cost with the cache */
+                                if (cache_bytes) {
+                                    p->cached_layers = layers;
+                                    p->sign_cached = (cost_prf_msg + cost_h_msg + cost_t_fors) +
+                                               amort_hypertree + k*cost_fors_tree +
+                                               k_tall*cost_taller;
+                                }
+
+                                /*
+                                 * If it can't be listed, neither can any with more
+                                 * FORS trees, or more taller ones (they cost more)
+                                 */
+                                if (prune) {
+                                    double cost = primary_key( p );
+                                    if (cost > prune_at[w_class]) {
+                                        free(p);
+                                        break;
+                                    }
+                                    if (cost < prune_at[w_class] && k_max_s < 0) {
+                                        k_max_s = fewest_trees( max_s + 1, h, a, k,
+                                                         k_limit-1, test_sec_level,
+                                                         &overuse_k[ 2*(h*30 + a) ] );
+                                    }
+                                    if (cost < prune_at[w_class] &&
+                                             k_max_s > 0 && k >= (unsigned)k_max_s) {
+                                        int j;
+                                        for (j = w_class; j < 3; j++) {
+                                            if (cost < prune_at[j]) prune_at[j] = cost;
+                                        }
+                                    }
+                                }
+
+                                if (dump) {
+                                    struct dump_record rec = { 0 };
+                                    rec.h = h; rec.d = d; rec.a = a; rec.k = k;
+                                    rec.n = hash_size; rec.m = digest_bytes( p );
+                                    rec.w = w;
+                                    rec.sig_size = p->sig_size;
+                                    rec.sig_time = p->sig_time;
+                                    rec.ver_time = p->ver_time;
+                                    dump_add( dump, &rec );
+                                }
+
+                                if (use_heap) {
+                                    /*
+                                     * If it doesn't get in, neither will any with
+                                     * more FORS trees, or more taller ones (they're
+                                     * bigger, and cost more)
+                                     */
+                                    const struct parameter_set *worst = heap_worst( &heap );
+                                    if (worst && !dump && my_compare( p, (struct parameter_set *)worst ) < 0) {
+                                        free( p );
+                                        break;
+                                    }
+                                    heap_add( &heap, p );
+                                } else {
+                                    p->link = *current_list;
+                                    *current_list = p;
+                                }
+                            }
+                            if (k_tall == 0) break;
+                        }
                     }
-                }
 
+                }
             }
         }
     }
 
+    if (dump) dump_close( dump );
+
+    if (params->stats) {
+        fprintf( stderr, "%llu security level evaluations; avoided %llu "
+                         "(too few FORS trees), %llu (too big), %llu (too "
+                         "slow to verify), %llu (already known)\n"
+                         "skipped %llu d and %llu a ranges (too big or too "
+                         "slow to verify)\n",
+                 sec_evals, evals_k_min, evals_size, evals_ver, evals_known,
+                 pruned_d, pruned_a );
+    }
+    free( secure_k );
+
+    /*
+     * With pareto=1, what we list is the frontier instead (which we sort
+     * later); we take everything off the lists for that
+     */
+    struct parameter_set *frontier = 0;
+    if (params->pareto) {
+        struct parameter_set **tail = &w16_q;
+        while (*tail) tail = &(*tail)->link;
+        *tail = w256_q;
+        while (*tail) tail = &(*tail)->link;
+        *tail = wother_q;
+        frontier = pareto_frontier( w16_q, test_sec_level, max_s,
+                                    params->stats );
+        w16_q = w256_q = wother_q = 0;
+    }
+
     /* Sort the queues into the order of decreasing goodness */
     w16_q = my_sort( w16_q );
     w256_q = my_sort( w256_q );
@@ -411,13 +2521,9 @@ void do_search( int sec_level, unsigned num_sig,
 
     /* And start printing out the table, in the format that can be pasted */
     /* directly into the Latex document */
-    printf( "\\begin{longtable}{c|c|c|c|c|c|c|c|c|c|c|c|c|c|c|c|c}\n" );
-    printf( "      &     &     &     &      &     &     &        &     & sec  &  pk   &  sig  & \\\% & sign & verify & sigs at & overuse \\\\\n" );
-    printf( "   ID & $n$ & $h$ & $d$ & $h'$ & $a$ & $k$ & $lg_w$ & $m$ & cat. & bytes & bytes & size & time & time   & level %d & safety \\\\\n", test_sec_level );
-#if 0
-    printf( "   ID & H  &  D &  A &  K &  W  &  SigSize & Sign Time & Verify Time & Sigs/level %d \\\\\n", test_sec_level );
-#endif
-    printf( "  \\hline \\endhead\n" );
+    if (params->format == FORMAT_LATEX) {
+        print_latex_header( params );
+    }
 
     /* Gather up the parameter sets to print */
     struct parameter_set *print_list = 0, **end_print_list;
@@ -431,6 +2537,30 @@ void do_search( int sec_level, unsigned num_sig,
                
     int cutoff[3] = { 0, 0, 0 };
     unsigned smallest_sig = UINT_MAX;
+
+    /*
+     * Many of them share h, a and k (they differ in w or d, or with
+     * mixed=1, in how the layers are split), and so have the same overuse;
+     * we remember it
+     */
+    struct overuse_memo memo;
+    struct parameter_set *const lists[3] = { w16_q, w256_q, wother_q };
+    unsigned total = 0, i;
+    for (i = 0; i < 3; i++) {
+        struct parameter_set *q;
+        for (q = lists[i]; q; q = q->link) total++;
+    }
+    for (memo.mask = 1; memo.mask < 2*total; memo.mask <<= 1) ;
+    memo.key = calloc( memo.mask, sizeof *memo.key );
+    memo.overuse = malloc( memo.mask * sizeof *memo.overuse );
+    memo.mask--;
+    memo.computed = 0;
+    memo.exact = 1;
+    if (!memo.key || !memo.overuse) {
+        fprintf( stderr, "Get a real computer you cheapskate\n" );
+        exit(1);
+    }
+
 //    unsigned smallest_overuse = UINT_MAX;
     while (w16_q || w256_q || wother_q) {
 
@@ -440,11 +2570,11 @@ void do_search( int sec_level, unsigned num_sig,
             /* Start with the best W=16 parameter set */
         { p = w16_q; winner = 0; }
             /* Switch to the best W=4,256 parameter set if it is better */
-        if (!p || (w256_q && w256_q->sig_size < p->sig_size)) {
+        if (!p || (w256_q && primary_key(w256_q) < primary_key(p))) {
             p = w256_q; winner = 1;
         }
             /* Switch to the best W=2,8,32,64,128 parameter set if better */
-        if (!p || (wother_q && wother_q->sig_size < p->sig_size)) {
+        if (!p || (wother_q && primary_key(wother_q) < primary_key(p))) {
             p = wother_q; winner = 2;
         }
 
@@ -467,7 +2597,8 @@ void do_search( int sec_level, unsigned num_sig,
          * which is the log2 of the number of signatures we can sign and
          * still be at the secondary security level (test_sec_level)
          */
-        int overuse = compute_sigs_at_sec_level( test_sec_level, p->h, p->a, p->k );
+        int overuse = memo_overuse( &memo, test_sec_level, p );
+        p->overuse = overuse;
         if (overuse <= min_sec_level[winner]) {
             /* Not as good as ones we've seen before */
             free(p);
@@ -505,68 +2636,120 @@ void do_search( int sec_level, unsigned num_sig,
         if (cutoff[0]) break;  /* If we've blocked everything, we might */
                                /* as well stop going through the lists */
     }
+    free( memo.key ); free( memo.overuse );
+
+    if (use_heap) {
+        /*
+         * With top=, we list everything we kept, in order; we haven't
+         * computed their overuse yet
+         */
+        struct parameter_set *p;
+        print_list = heap_to_list( &heap );
+        free( heap.set );
+        for (p = print_list; p; p = p->link) {
+            p->overuse = compute_sigs_at_sec_level_mixed( test_sec_level,
+                                            p->h, p->a, p->k, p->k_tall );
+            if (p->sig_size < smallest_sig) smallest_sig = p->sig_size;
+        }
+    }
+    if (params->pareto) {
+        struct parameter_set *p;
+        unsigned listed = 0;
+        print_list = my_sort( frontier );
+        for (p = print_list; p; p = p->link) {
+            if (p->sig_size < smallest_sig) smallest_sig = p->sig_size;
+            if (++listed == params->top) {
+                /* That's all top= wants */
+                while (p->link) {
+                    struct parameter_set *q = p->link;
+                    p->link = q->link;
+                    free( q );
+                }
+            }
+        }
+    }
 
     /* Ok, we have the list - print them out */
+    static struct writer out;
+    writer_init( &out, stdout );
+    struct curve_store *curves = 0;
+    if (params->curves_file) {
+        curves = curve_store_open( params->curves_file );
+    }
     int count = 0;
     for (; print_list; print_list = print_list->link) {
         struct parameter_set *p = print_list;
+        char id[100], filename[200];
 
         count++;
         if (label) {
-            printf( "  %s-", label );
-            int k = strlen( label ) + 1 + printf( "%d", count );
-            for (; k<4; k++) printf( " " );
-            printf( "& " );
+            sprintf( id, "%.80s-%d", label, count );
         } else {
-            printf( "  %4d & ", count );
-        } 
-	int m = divru(p->h - p->h/p->d, 8) + divru(p->h/p->d, 8) + divru(p->a*p->k, 8);
-        int overuse = compute_sigs_at_sec_level( test_sec_level, p->h, p->a, p->k );
-//	int delta_overuse = overuse - smallest_overuse;
-        printf( "%2d & %3d & %2d & %2d & %2d & %2d &   %d  & %2d &    %d     &     %d   & %  8d  & %d\\\% & % 9d & % 11d & %d.%02d & %u \\\\\n",
-	         sec_level/8,
-                       p->h, p->d, p->h/p->d, p->a, p->k, ilog2(p->w), m,
-		       (sec_level/64)*2 - 3, 2*(sec_level/8),
-		                           p->sig_size, 100*p->sig_size / smallest_sig, p->sig_time,
-                                                               p->ver_time,
-                   overuse/100, overuse % 100, (unsigned)pow(2, (float)overuse/100 - num_sig ) );
-#if 0
-        printf( "%2d & %2d & %2d & %2d & %3d & % 8d & % 9d & % 11d & %d.%02d \\\\\n",
-                 p->h, p->d,  p->a,p->k, p->w,   p->sig_size,
-                                                        p->sig_time,
-                                                               p->ver_time,
-                   overuse/100, overuse % 100 );
-#endif
+            sprintf( id, "%d", count );
+        }
+        if (curves) {
+            sprintf( filename, "%.180s#%d", params->curves_file, count-1 );
+        } else {
+            sprintf( filename, "%s.csv", id );
+        }
+
+        switch (params->format) {
+        case FORMAT_LATEX:
+            print_latex_row( params, p, count, smallest_sig );
+            break;
+        case FORMAT_JSONL:
+            write_jsonl_row( &out, params, p, count,
+                             (label || curves) ? filename : 0 );
+            break;
+        }
+
+        if (count <= params->bench) {
+            if (count == 1) {
+                fprintf( stderr, "Built-in SLH-DSA (%s) timings, in microseconds:\n",
+                         hash_name( params->hash ? params->hash : HASH_SHA2 ));
+                fprintf( stderr, "    ID  sign model    measured  ratio   signs/s  ver model   measured  ratio verifies/s\n" );
+            }
+            benchmark_set( params, p, id );
+        }
 
         /* If the user asked for the overuse graph being dumped to a file, */
         /* compute and write those values */
-        if (label) {
-            char filename[200];
-            sprintf( filename, "%s-%d.csv", label, count );
+        if (curves) {
+            unsigned n = compute_overuse_curve( params, p );
+            curve_store_add( curves, id, p->h, p->d, p->a, p->k, p->w,
+                             n, curve_x, curve_y );
+        } else if (label) {
             FILE *f = fopen( filename, "w" );
             if (!f) {
                 fprintf( stderr, "Unable to open %s\n", filename );
-                goto skip_file_output;
+                continue;
             }
-            unsigned x;
-            for (x = 100*(num_sig-1); x < 100*(max_s+10); x++) {
-                double fx = x / 100.0;
-                double y = compute_sec_level(fx, p->h, p->a, p->k);
-                if (y > sec_level) y = sec_level;
-                if (y < 10) break;  /* No reason to list where the security */
-                                    /* level drops to below '10 bits' */
-                fprintf( f, "%f, %f\n", fx, y );
+            unsigned j, n = compute_overuse_curve( params, p );
+            for (j = 0; j < n; j++) {
+                fprintf( f, "%f, %f\n", curve_x[j], curve_y[j] );
             }
             fclose(f);
-skip_file_output:;
         }
     }
+    if (curves) curve_store_close( curves );
+    if (!writer_flush( &out )) {
+        fprintf( stderr, "Error writing output\n" );
+    }
+
+    if (params->format != FORMAT_LATEX) return;
 
     /*
      * And print out the table trailer
      */
-    printf( "\\caption{Selection set (%d, %d, $2^{%d}$, %s)}\n",
-            sec_level, test_sec_level, num_sig, commify( sign_op ) );
+    /* (the sign budget is in microseconds if it was given with signus=) */
+    char budget_text[ 40 ];
+    if (sign_us) snprintf( budget_text, sizeof budget_text, "%g $\\mu$s",
+                           sign_us );
+    else snprintf( budget_text, sizeof budget_text, "%s", commify( sign_op ) );
+    printf( "\\caption{Selection set (%d, %d, $2^{%d}$, %s%s%s)}\n",
+            sec_level, test_sec_level, num_sig, budget_text,
+            params->hash ? ", " : "",
+            params->hash ? hash_name( params->hash ) : "" );
     if (label) {
         printf( "\\label{table:%s}\n", label );
     }
@@ -1,3 +1,58 @@
-void do_search( int sec_level, unsigned num_sig, unsigned test_sig,
-                unsigned test_sec_level, int max_s, char *label,
-                int d, int h, int a );
+/*
+ * What we're searching for; see do_search for what these mean
+ */
+struct search_params {
+    int sec_level;
+    unsigned num_sig;
+    unsigned test_sec_level;
+    unsigned sign_op;
+    int max_s;
+    char *label;
+    int d_restrict, h_restrict, a_restrict;
+    int format;
+    char *curves_file;
+    double curve_tol;
+    int curve_pts;
+    char *dump_file;
+    int hash;                   /* HASH_ABSTRACT, HASH_SHA2, HASH_SHAKE */
+    int predict;
+    double sign_us;
+    int bench;
+    unsigned lanes;             /* Multi-buffer width (0 = don't compute) */
+    unsigned cores;             /* Cores to sign on (0 = don't compute) */
+    double cache_mb;            /* Memory for cached hypertree layers */
+    unsigned keygen_op;         /* Max hashes during key generation */
+    unsigned mem_bytes;         /* Max signer memory */
+    int budget;                 /* Which costs sign= limits, and we rank by */
+    int objective;              /* What we list parameter sets in order of */
+    double w_byte, w_sign, w_ver; /* The weights for OBJECTIVE_WEIGHTED */
+    int rank;                   /* Which of those we list in order of first */
+    int pareto;                 /* List the Pareto frontier instead */
+    unsigned top;               /* List just this many (0 = no limit) */
+    unsigned max_sig;           /* Max signature size (0 = no limit) */
+    unsigned max_ver;           /* Max verify hashes (0 = no limit) */
+    int mixed;                  /* Let the Merkle trees differ in height */
+    int forsmix;                /* ... and the FORS trees */
+    int stats;                  /* Report the evaluations made and avoided */
+};
+
+/* The output formats */
+#define FORMAT_LATEX 0
+#define FORMAT_JSONL 1
+
+/* The cost models budget= can pick */
+#define BUDGET_SERIAL 0     /* One hash at a time (the default) */
+#define BUDGET_LANES  1     /* Multi-buffer, lanes= hashes at a time */
+#define BUDGET_CORES  2     /* Latency, with the trees on cores= cores */
+#define BUDGET_CACHED 3     /* Amortized, with cache= MB of top layers */
+
+/* What we rank parameter sets by */
+#define OBJECTIVE_SIZE     0    /* Signature size (the default) */
+#define OBJECTIVE_WEIGHTED 1    /* Weighted sum of the size and costs */
+
+/* Which we list parameter sets in order of first */
+#define RANK_SIZE   0       /* The objective (the default) */
+#define RANK_SIGN   1       /* The sign cost */
+#define RANK_VERIFY 2       /* The verify cost */
+
+void do_search( const struct search_params *params );
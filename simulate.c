@@ -0,0 +1,315 @@
+/*
+ * This is the program that lists the potential Sphincs+ parameter sets,
+ * given the target requirements (security level, number of signatures at
+ * that security level, overuse characteristics)
+ *
+ * This part of the program is a Monte Carlo simulation of the FORS security
+ * model; it is here so that we can check equation (1) of the paper (which is
+ * what compute_sec_level evaluates) against what actually happens when we
+ * generate that many signatures
+ *
+ * What we simulate is this: we generate 2^m signatures, each at a random
+ * hypertree leaf (out of 2^H), and each such signature reveals one random
+ * leaf in each of the K FORS trees (each with 2^T leaves) of the FORS
+ * instance at that hypertree leaf.  The attacker then makes a forgery query;
+ * that picks a random hypertree leaf, and a random leaf in each FORS tree;
+ * it succeeds if all K of those leaves have already been revealed
+ *
+ * Doing that literally is out of the question for the m we care about, so
+ * we do it a FORS instance at a time, stratified by g, the number of
+ * signatures that landed on that instance:
+ * - The probability that a random instance got g signatures is the binomial
+ *   probability Pr(g) (we compute that exactly, rather than using the Poisson
+ *   approximation that equation (1) uses)
+ * - Given g, we simulate the instance: for each of the K FORS trees, we
+ *   hash the (instance, tree, signature) counter into a leaf index, and
+ *   count how many distinct leaves were revealed.  The probability that a
+ *   query hits revealed leaves in all the trees is then the product of
+ *   (distinct leaves revealed / 2^T) over the trees; we use that instead of
+ *   simulating the query itself, as it has far less variance
+ * The forgery probability is then sum over g of Pr(g) * E[product | g]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "simulate.h"
+#include "gamma.h"
+
+#define MAX_STRATA 4096     /* We don't look at more than this many g values */
+#define STRATA_RANGE 40     /* We ignore g values whose contribution is */
+                            /* bounded by 2^-40 times the largest one */
+
+/*
+ * The counter based random number generator.  Every random value we use is
+ * a hash of where it's used (the stratum, the trial, the FORS tree, and
+ * which signature); that means that the results don't depend on how the
+ * work is split among the threads, and that we can compute a whole run of
+ * leaf indices at once (which the compiler turns into vector code)
+ */
+static unsigned long long mix64( unsigned long long z ) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ * Compute the leaf indices revealed by count signatures within one FORS
+ * tree; the 64 bit key identifies the tree (and the trial and stratum)
+ * This is where the simulation spends its time; it is built for each vector
+ * instruction set, and the one the CPU supports is picked at load time
+ */
+__attribute__((target_clones("avx512f", "avx2", "default")))
+static void hash_leaves( unsigned long long key, unsigned count,
+                         unsigned mask, unsigned *leaf ) {
+    unsigned key_lo = (unsigned)key, key_hi = (unsigned)(key >> 32);
+    unsigned i;
+    for (i = 0; i < count; i++) {
+        /* The murmur3 finalizer, on the counter mixed with the key */
+        unsigned h = (i * 0x9e3779b9u + key_lo) ^ key_hi;
+        h ^= h >> 16; h *= 0x85ebca6bu;
+        h ^= h >> 13; h *= 0xc2b2ae35u;
+        h ^= h >> 16;
+        leaf[i] = h & mask;
+    }
+}
+
+/*
+ * Per thread working storage, used to count distinct revealed leaves
+ * It is an open addressing hash table; rather than clearing it each time,
+ * we tag each entry with the current generation
+ */
+struct workspace {
+    unsigned *leaf;         /* The leaves revealed in this FORS tree */
+    unsigned *slot_leaf;    /* The hash table */
+    unsigned *slot_gen;
+    unsigned table_mask;
+    unsigned generation;
+};
+
+static unsigned count_distinct( struct workspace *w, unsigned count ) {
+    unsigned i, distinct = 0;
+    w->generation++;
+    for (i = 0; i < count; i++) {
+        unsigned x = w->leaf[i];
+        unsigned s = (x * 0x9e3779b9u) & w->table_mask;
+        for (;;) {
+            if (w->slot_gen[s] != w->generation) {
+                w->slot_gen[s] = w->generation;
+                w->slot_leaf[s] = x;
+                distinct++;
+                break;
+            }
+            if (w->slot_leaf[s] == x) break;
+            s = (s + 1) & w->table_mask;
+        }
+    }
+    return distinct;
+}
+
+/*
+ * What we're simulating, and the totals from the threads
+ */
+static struct {
+    int T, K;
+    unsigned long trials;       /* Per stratum */
+    unsigned long long seed;
+    int num_strata;
+    unsigned g[ MAX_STRATA ];   /* The number of signatures in each stratum */
+    double sum[ MAX_STRATA ];   /* Sum of the per trial probabilities */
+    double sum_sq[ MAX_STRATA ];/* ... and their squares */
+    pthread_mutex_t lock;
+} sim = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+struct thread_arg {
+    unsigned long first, last;  /* The trials this thread does */
+};
+
+static void *worker( void *varg ) {
+    struct thread_arg *arg = varg;
+    unsigned max_g = 0;
+    int s;
+    for (s = 0; s < sim.num_strata; s++) {
+        if (sim.g[s] > max_g) max_g = sim.g[s];
+    }
+
+    struct workspace w;
+    unsigned table_size = 1;
+    while (table_size < 2*max_g) table_size <<= 1;
+    w.leaf = malloc( max_g * sizeof *w.leaf );
+    w.slot_leaf = malloc( table_size * sizeof *w.slot_leaf );
+    w.slot_gen = calloc( table_size, sizeof *w.slot_gen );
+    w.table_mask = table_size - 1;
+    w.generation = 0;
+    double *sum = calloc( sim.num_strata, sizeof *sum );
+    double *sum_sq = calloc( sim.num_strata, sizeof *sum_sq );
+    if (!w.leaf || !w.slot_leaf || !w.slot_gen || !sum || !sum_sq) {
+        fprintf( stderr, "Get a real computer you cheapskate\n" );
+        exit(1);
+    }
+
+    unsigned mask = (unsigned)((1ULL << sim.T) - 1);
+    double scale = ldexp( 1.0, -sim.T );
+
+    for (s = 0; s < sim.num_strata; s++) {
+        unsigned g = sim.g[s];
+        unsigned long trial;
+        for (trial = arg->first; trial < arg->last; trial++) {
+            unsigned long long instance = mix64( sim.seed ^
+                            ((unsigned long long)g << 40) ^ trial );
+            double prob = 1.0;
+            int tree;
+            for (tree = 0; tree < sim.K; tree++) {
+                hash_leaves( mix64( instance + tree ), g, mask, w.leaf );
+                prob *= count_distinct( &w, g ) * scale;
+            }
+            sum[s] += prob;
+            sum_sq[s] += prob * prob;
+        }
+    }
+
+    pthread_mutex_lock( &sim.lock );
+    for (s = 0; s < sim.num_strata; s++) {
+        sim.sum[s] += sum[s];
+        sim.sum_sq[s] += sum_sq[s];
+    }
+    pthread_mutex_unlock( &sim.lock );
+
+    free( w.leaf ); free( w.slot_leaf ); free( w.slot_gen );
+    free( sum ); free( sum_sq );
+    return 0;
+}
+
+/*
+ * Return the natural log of the probability that a specific hypertree leaf
+ * gets precisely g of the 2^m signatures (each of which picks one of the 2^H
+ * leaves at random), that is, the binomial distribution
+ * We don't use lgamma(2^m), as that loses all precision when m is large
+ */
+static double log_binomial( double m, int H, unsigned g ) {
+    double n = exp2( m );
+    double log_p = -H * log(2.0);
+    double r = g * (m * log(2.0) + log_p) - lgamma( g + 1.0 );
+    unsigned i;
+    for (i = 1; i < g; i++) {
+        r += log1p( -(double)i / n );
+    }
+    return r + (n - g) * log1p( -exp( log_p ) );
+}
+
+/*
+ * Run the simulation for 2^m signatures; this returns the simulated
+ * security level, and (via *sigma) the standard error of that estimate,
+ * in bits
+ */
+static double simulate_point( double m, int H, int T, int K,
+                              unsigned long trials, int num_threads,
+                              double *sigma ) {
+    /*
+     * Pick the strata: an instance with g signatures contributes at most
+     * Pr(g) * min(1, g/2^T)^K, so we can skip any g for which that bound is
+     * negligible
+     */
+    double log_weight[ MAX_STRATA ];
+    double best = -HUGE_VAL;
+    double lambda = exp2( m - H );
+    unsigned g;
+    sim.num_strata = 0;
+    for (g = 1; sim.num_strata < MAX_STRATA && g < exp2( m ); g++) {
+        double lw = log_binomial( m, H, g );
+        double frac = g * ldexp( 1.0, -T );
+        double bound = lw + K * log( frac < 1 ? frac : 1 );
+        if (bound > best) best = bound;
+        if (bound < best - STRATA_RANGE * log(2.0)) {
+            if (g > lambda) break;  /* We're past the peak; it only */
+                                    /* gets smaller from here */
+            continue;
+        }
+        sim.g[ sim.num_strata ] = g;
+        log_weight[ sim.num_strata ] = lw;
+        sim.sum[ sim.num_strata ] = sim.sum_sq[ sim.num_strata ] = 0;
+        sim.num_strata++;
+    }
+
+    sim.T = T;
+    sim.K = K;
+    sim.trials = trials;
+
+    pthread_t thread[ num_threads ];
+    struct thread_arg arg[ num_threads ];
+    int started[ num_threads ];
+    int i;
+    for (i = 0; i < num_threads; i++) {
+        arg[i].first = trials * i / num_threads;
+        arg[i].last = trials * (i+1) / num_threads;
+        started[i] = (0 == pthread_create( &thread[i], 0, worker, &arg[i] ));
+        if (!started[i]) {
+            worker( &arg[i] );  /* Couldn't start it; do it ourselves */
+        }
+    }
+    for (i = 0; i < num_threads; i++) {
+        if (started[i]) pthread_join( thread[i], 0 );
+    }
+
+    /*
+     * Combine the strata.  We keep the probability scaled by e^-scale, as
+     * the weights can be far too small to represent directly
+     */
+    double scale = -HUGE_VAL;
+    int s;
+    for (s = 0; s < sim.num_strata; s++) {
+        if (log_weight[s] > scale) scale = log_weight[s];
+    }
+    double prob = 0, var = 0;
+    for (s = 0; s < sim.num_strata; s++) {
+        double w = exp( log_weight[s] - scale );
+        double mean = sim.sum[s] / trials;
+        double v = sim.sum_sq[s] / trials - mean * mean;
+        if (v < 0) v = 0;
+        prob += w * mean;
+        var += w * w * v / trials;
+    }
+
+    if (prob <= 0) {
+        *sigma = HUGE_VAL;
+        return HUGE_VAL;
+    }
+    /* Convert to bits; the standard error of -log2(p) is about */
+    /* sigma_p / (p ln 2) */
+    *sigma = sqrt( var ) / (prob * log(2.0));
+    return -(log2( prob ) + scale / log(2.0));
+}
+
+/*
+ * Run the Monte Carlo simulation for a hypertree of height H, with K FORS
+ * trees of height T, after 2^m signatures for each m from m_first to m_last,
+ * and print what we find next to what compute_sec_level says
+ * trials      - The number of simulated FORS instances for each value of g
+ * num_threads - How many threads to use; 0 means one per CPU
+ */
+void run_simulation( int H, int T, int K, int m_first, int m_last,
+                     unsigned long trials, int num_threads ) {
+    if (num_threads <= 0) {
+        long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+        num_threads = cpus > 0 ? cpus : 1;
+    }
+    if (m_last < m_first) m_last = m_first;
+    sim.seed = 0x5eed;
+
+    printf( "Monte Carlo check of H=%d, a=%d, k=%d (%lu trials per stratum)\n",
+            H, T, K, trials );
+    printf( "  log2 sigs   model sec   simulated sec   +/- (1 sigma)   model - sim\n" );
+
+    int m;
+    for (m = m_first; m <= m_last; m++) {
+        double sigma;
+        double model = compute_sec_level( m, H, T, K );
+        double sim_level = simulate_point( m, H, T, K, trials, num_threads,
+                                           &sigma );
+        printf( "  %9d  %10.3f  %14.3f  %14.3f  %12.3f\n",
+                m, model, sim_level, sigma, model - sim_level );
+        fflush( stdout );
+    }
+}
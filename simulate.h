@@ -0,0 +1,2 @@
+void run_simulation( int H, int T, int K, int m_first, int m_last,
+                     unsigned long trials, int num_threads );
@@ -0,0 +1,647 @@
+/*
+ * This is the program that lists the potential Sphincs+ parameter sets,
+ * given the target requirements (security level, number of signatures at
+ * that security level, overuse characteristics)
+ *
+ * This part of the program is a straight-forward implementation of SLH-DSA
+ * (FIPS 205) signing and verification, generalized to any parameter set the
+ * search comes up with (any h, d, a, k, w and n), with either the SHAKE or
+ * the SHA2 hash functions.  It is here so that we can time real signature
+ * operations with the parameter sets we list, and compare that against what
+ * the cost model says; if they drift apart, the model needs fixing
+ *
+ * It follows the algorithms in FIPS 205 fairly literally; it isn't tuned
+ * (other than computing the state after the PK.seed block once for SHA2,
+ * which the cost model assumes, and which every real implementation does),
+ * and it is not constant time.  It is not meant for real signatures
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "slhdsa.h"
+#include "hash.h"
+#include "cost.h"
+
+#define MAX_N 32
+#define MAX_DIGEST 512  /* Longest message digest we handle */
+
+/* The address types */
+#define ADRS_WOTS_HASH  0
+#define ADRS_WOTS_PK    1
+#define ADRS_TREE       2
+#define ADRS_FORS_TREE  3
+#define ADRS_FORS_ROOTS 4
+#define ADRS_WOTS_PRF   5
+#define ADRS_FORS_PRF   6
+
+struct slh_key {
+    int hash;
+    unsigned n, h, d, hp, a, k, lg_w, w;
+    unsigned len1, len2, len;   /* WOTS digits (message, checksum, total) */
+    unsigned m;                 /* Message digest size */
+    unsigned char sk_seed[ MAX_N ], sk_prf[ MAX_N ];
+    unsigned char pk_seed[ MAX_N ], pk_root[ MAX_N ];
+    uint32_t seed_state256[8];  /* The state after the PK.seed block */
+    uint64_t seed_state512[8];
+    unsigned char *buf;         /* Scratch space for hash inputs */
+};
+
+/*
+ * The ADRS structure
+ */
+typedef unsigned char adrs_t[32];
+
+static void set32( unsigned char *p, uint32_t v ) {
+    p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+static uint32_t get32( const unsigned char *p ) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void set_layer( adrs_t a, uint32_t layer ) { set32( a, layer ); }
+static void set_tree( adrs_t a, uint64_t tree ) {
+    set32( a + 4, 0 );
+    set32( a + 8, tree >> 32 );
+    set32( a + 12, (uint32_t)tree );
+}
+/* Changing the type clears the rest of the structure */
+static void set_type( adrs_t a, uint32_t type ) {
+    set32( a + 16, type );
+    memset( a + 20, 0, 12 );
+}
+static void set_keypair( adrs_t a, uint32_t v ) { set32( a + 20, v ); }
+static uint32_t get_keypair( const adrs_t a ) { return get32( a + 20 ); }
+static void set_chain( adrs_t a, uint32_t v ) { set32( a + 24, v ); }
+static void set_tree_height( adrs_t a, uint32_t v ) { set32( a + 24, v ); }
+static void set_hash( adrs_t a, uint32_t v ) { set32( a + 28, v ); }
+static void set_tree_index( adrs_t a, uint32_t v ) { set32( a + 28, v ); }
+static uint32_t get_tree_index( const adrs_t a ) { return get32( a + 28 ); }
+
+/*
+ * The tweakable hash: out = Th( PK.seed, ADRS, in ), where in is count
+ * values of n bytes (so F is count=1, H is count=2 and T_l is count=l); this
+ * is also PRF, with in being SK.seed.  op is which one it is (OP_PRF, OP_F,
+ * OP_H or OP_T); that decides which hash SHA2 uses
+ */
+static void thash( struct slh_key *key, int op, unsigned char *out,
+                   const adrs_t adrs, const unsigned char *in,
+                   unsigned count ) {
+    unsigned n = key->n;
+    unsigned char *buf = key->buf;
+    unsigned char digest[64];
+    if (key->hash == HASH_SHAKE) {
+        memcpy( buf, key->pk_seed, n );
+        memcpy( buf + n, adrs, 32 );
+        memcpy( buf + n + 32, in, count * n );
+        shake256( out, n, buf, n + 32 + count * n );
+        return;
+    }
+
+    /* SHA2: the compressed ADRS, and then the input */
+    buf[0] = adrs[3];
+    memcpy( buf + 1, adrs + 8, 8 );
+    buf[9] = adrs[19];
+    memcpy( buf + 10, adrs + 20, 12 );
+    memcpy( buf + 22, in, count * n );
+    if (hash_op_prim( key->hash, op, n ) == PRIM_SHA256) {
+        sha256_tail( key->seed_state256, 64, buf, 22 + count * n, digest );
+    } else {
+        sha512_tail( key->seed_state512, 128, buf, 22 + count * n, digest );
+    }
+    memcpy( out, digest, n );
+}
+
+/*
+ * The SHA-2 hash the message functions use (SHA-256 for n = 16, otherwise
+ * SHA-512); returns the hash size
+ */
+static unsigned msg_hash( const struct slh_key *key, unsigned char *out,
+                          const unsigned char *in, size_t len ) {
+    if (hash_op_prim( key->hash, OP_H_MSG, key->n ) == PRIM_SHA256) {
+        uint32_t s[8];
+        sha256_init( s );
+        sha256_tail( s, 0, in, len, out );
+        return 32;
+    } else {
+        uint64_t s[8];
+        sha512_init( s );
+        sha512_tail( s, 0, in, len, out );
+        return 64;
+    }
+}
+
+/*
+ * PRF_msg( SK.prf, opt_rand, M ); opt_rand is PK.seed (deterministic
+ * signing)
+ */
+static void prf_msg( struct slh_key *key, unsigned char *out,
+                     const unsigned char *msg, size_t len ) {
+    unsigned n = key->n;
+    unsigned char *buf = malloc( 128 + n + len + 1 );
+    if (!buf) abort();
+    if (key->hash == HASH_SHAKE) {
+        memcpy( buf, key->sk_prf, n );
+        memcpy( buf + n, key->pk_seed, n );
+        memcpy( buf + 2*n, msg, len );
+        shake256( out, n, buf, 2*n + len );
+    } else {
+        /* HMAC( SK.prf, opt_rand || M ) */
+        unsigned block = (hash_op_prim( key->hash, OP_PRF_MSG, n ) ==
+                          PRIM_SHA256) ? 64 : 128;
+        unsigned char inner[64], outer[128 + 64];
+        unsigned i, hash_len;
+        for (i=0; i<block; i++) buf[i] = (i < n ? key->sk_prf[i] : 0) ^ 0x36;
+        memcpy( buf + block, key->pk_seed, n );
+        memcpy( buf + block + n, msg, len );
+        hash_len = msg_hash( key, inner, buf, block + n + len );
+        for (i=0; i<block; i++) outer[i] = (i < n ? key->sk_prf[i] : 0) ^ 0x5c;
+        memcpy( outer + block, inner, hash_len );
+        msg_hash( key, inner, outer, block + hash_len );
+        memcpy( out, inner, n );
+    }
+    free( buf );
+}
+
+/*
+ * H_msg( R, PK.seed, PK.root, M ); writes key->m bytes
+ */
+static void h_msg( struct slh_key *key, unsigned char *out,
+                   const unsigned char *r, const unsigned char *msg,
+                   size_t len ) {
+    unsigned n = key->n;
+    unsigned char *buf = malloc( 3*n + len + 1 );
+    if (!buf) abort();
+    memcpy( buf, r, n );
+    memcpy( buf + n, key->pk_seed, n );
+    memcpy( buf + 2*n, key->pk_root, n );
+    memcpy( buf + 3*n, msg, len );
+    if (key->hash == HASH_SHAKE) {
+        shake256( out, key->m, buf, 3*n + len );
+    } else {
+        /* MGF1( R || PK.seed || SHA-x( R || PK.seed || PK.root || M ), m ) */
+        unsigned char seed[ 2*MAX_N + 64 + 4 ], block[64];
+        unsigned hash_len = msg_hash( key, seed + 2*n, buf, 3*n + len );
+        unsigned done, counter;
+        memcpy( seed, r, n );
+        memcpy( seed + n, key->pk_seed, n );
+        for (done = 0, counter = 0; done < key->m; done += hash_len, counter++) {
+            set32( seed + 2*n + hash_len, counter );
+            msg_hash( key, block, seed, 2*n + hash_len + 4 );
+            unsigned take = key->m - done < hash_len ? key->m - done : hash_len;
+            memcpy( out + done, block, take );
+        }
+    }
+    free( buf );
+}
+
+/*
+ * Split a byte string into count digits of b bits each (base_2b in FIPS 205)
+ */
+static void base_2b( unsigned *digits, const unsigned char *in, unsigned b,
+                     unsigned count ) {
+    uint64_t total = 0;
+    unsigned bits = 0, i;
+    for (i=0; i<count; i++) {
+        while (bits < b) {
+            total = (total << 8) | *in++;
+            bits += 8;
+        }
+        bits -= b;
+        digits[i] = (total >> bits) & ((1u << b) - 1);
+    }
+}
+
+static uint64_t to_int( const unsigned char *in, unsigned len ) {
+    uint64_t r = 0;
+    while (len--) r = (r << 8) | *in++;
+    return r;
+}
+
+/*
+ * WOTS+
+ */
+static void chain( struct slh_key *key, unsigned char *out,
+                   const unsigned char *in, unsigned start, unsigned steps,
+                   adrs_t adrs ) {
+    unsigned j;
+    memcpy( out, in, key->n );
+    for (j = start; j < start + steps; j++) {
+        set_hash( adrs, j );
+        thash( key, OP_F, out, adrs, out, 1 );
+    }
+}
+
+/* Compute the WOTS private value for chain i */
+static void wots_sk( struct slh_key *key, unsigned char *out,
+                     const adrs_t adrs, unsigned i ) {
+    adrs_t sk_adrs;
+    memcpy( sk_adrs, adrs, 32 );
+    set_type( sk_adrs, ADRS_WOTS_PRF );
+    set_keypair( sk_adrs, get_keypair( adrs ) );
+    set_chain( sk_adrs, i );
+    thash( key, OP_PRF, out, sk_adrs, key->sk_seed, 1 );
+}
+
+/* Compress the chain heads into the public key */
+static void wots_compress( struct slh_key *key, unsigned char *out,
+                           const adrs_t adrs, const unsigned char *heads ) {
+    adrs_t pk_adrs;
+    memcpy( pk_adrs, adrs, 32 );
+    set_type( pk_adrs, ADRS_WOTS_PK );
+    set_keypair( pk_adrs, get_keypair( adrs ) );
+    thash( key, OP_T, out, pk_adrs, heads, key->len );
+}
+
+static void wots_pkgen( struct slh_key *key, unsigned char *out, adrs_t adrs ) {
+    unsigned n = key->n, i;
+    unsigned char *heads = malloc( key->len * n );
+    unsigned char sk[ MAX_N ];
+    if (!heads) abort();
+    for (i=0; i<key->len; i++) {
+        wots_sk( key, sk, adrs, i );
+        set_chain( adrs, i );
+        chain( key, heads + i*n, sk, 0, key->w - 1, adrs );
+    }
+    wots_compress( key, out, adrs, heads );
+    free( heads );
+}
+
+/* The digits we sign for message msg (n bytes), including the checksum */
+static void wots_digits( const struct slh_key *key, unsigned *digits,
+                         const unsigned char *msg ) {
+    unsigned i, csum = 0;
+    unsigned char csum_bytes[8];
+
+    /*
+     * If lg_w doesn't divide 8n, the last digit runs off the end of the
+     * message; FIPS 205 doesn't have to deal with that (it only has w=16),
+     * we pad the message with zero bits
+     */
+    unsigned char padded[ MAX_N + 1 ];
+    memcpy( padded, msg, key->n );
+    padded[ key->n ] = 0;
+    base_2b( digits, padded, key->lg_w, key->len1 );
+    for (i=0; i<key->len1; i++) csum += key->w - 1 - digits[i];
+    unsigned csum_bits = key->len2 * key->lg_w;
+    csum <<= (8 - csum_bits % 8) % 8;
+    unsigned csum_len = (csum_bits + 7) / 8;
+    for (i=0; i<csum_len; i++) csum_bytes[i] = csum >> (8 * (csum_len-1-i));
+    base_2b( digits + key->len1, csum_bytes, key->lg_w, key->len2 );
+}
+
+static void wots_sign( struct slh_key *key, unsigned char *sig,
+                       const unsigned char *msg, adrs_t adrs ) {
+    unsigned digits[ 8*MAX_N + 32 ], i;
+    unsigned char sk[ MAX_N ];
+    wots_digits( key, digits, msg );
+    for (i=0; i<key->len; i++) {
+        wots_sk( key, sk, adrs, i );
+        set_chain( adrs, i );
+        chain( key, sig + i*key->n, sk, 0, digits[i], adrs );
+    }
+}
+
+static void wots_pk_from_sig( struct slh_key *key, unsigned char *out,
+                              const unsigned char *sig,
+                              const unsigned char *msg, adrs_t adrs ) {
+    unsigned digits[ 8*MAX_N + 32 ], i, n = key->n;
+    unsigned char *heads = malloc( key->len * n );
+    if (!heads) abort();
+    wots_digits( key, digits, msg );
+    for (i=0; i<key->len; i++) {
+        set_chain( adrs, i );
+        chain( key, heads + i*n, sig + i*n, digits[i],
+               key->w - 1 - digits[i], adrs );
+    }
+    wots_compress( key, out, adrs, heads );
+    free( heads );
+}
+
+/*
+ * XMSS
+ */
+static void xmss_node( struct slh_key *key, unsigned char *out, uint32_t i,
+                       unsigned z, adrs_t adrs ) {
+    if (z == 0) {
+        set_type( adrs, ADRS_WOTS_HASH );
+        set_keypair( adrs, i );
+        wots_pkgen( key, out, adrs );
+        return;
+    }
+    unsigned char nodes[ 2*MAX_N ];
+    xmss_node( key, nodes, 2*i, z-1, adrs );
+    xmss_node( key, nodes + key->n, 2*i+1, z-1, adrs );
+    set_type( adrs, ADRS_TREE );
+    set_tree_height( adrs, z );
+    set_tree_index( adrs, i );
+    thash( key, OP_H, out, adrs, nodes, 2 );
+}
+
+/* The signature is the WOTS signature, followed by the auth path */
+static void xmss_sign( struct slh_key *key, unsigned char *sig,
+                       const unsigned char *msg, uint32_t idx, adrs_t adrs ) {
+    unsigned j, n = key->n;
+    unsigned char *auth = sig + key->len * n;
+    for (j=0; j<key->hp; j++) {
+        xmss_node( key, auth + j*n, (idx >> j) ^ 1, j, adrs );
+    }
+    set_type( adrs, ADRS_WOTS_HASH );
+    set_keypair( adrs, idx );
+    wots_sign( key, sig, msg, adrs );
+}
+
+static void xmss_pk_from_sig( struct slh_key *key, unsigned char *out,
+                              uint32_t idx, const unsigned char *sig,
+                              const unsigned char *msg, adrs_t adrs ) {
+    unsigned j, n = key->n;
+    const unsigned char *auth = sig + key->len * n;
+    unsigned char nodes[ 2*MAX_N ];
+    set_type( adrs, ADRS_WOTS_HASH );
+    set_keypair( adrs, idx );
+    wots_pk_from_sig( key, out, sig, msg, adrs );
+    set_type( adrs, ADRS_TREE );
+    set_tree_index( adrs, idx );
+    for (j=0; j<key->hp; j++) {
+        set_tree_height( adrs, j+1 );
+        if (((idx >> j) & 1) == 0) {
+            set_tree_index( adrs, get_tree_index( adrs ) / 2 );
+            memcpy( nodes, out, n );
+            memcpy( nodes + n, auth + j*n, n );
+        } else {
+            set_tree_index( adrs, (get_tree_index( adrs ) - 1) / 2 );
+            memcpy( nodes, auth + j*n, n );
+            memcpy( nodes + n, out, n );
+        }
+        thash( key, OP_H, out, adrs, nodes, 2 );
+    }
+}
+
+/*
+ * The hypertree
+ */
+static unsigned xmss_sig_bytes( const struct slh_key *key ) {
+    return (key->len + key->hp) * key->n;
+}
+
+static void ht_sign( struct slh_key *key, unsigned char *sig,
+                     const unsigned char *msg, uint64_t idx_tree,
+                     uint32_t idx_leaf ) {
+    adrs_t adrs = { 0 };
+    unsigned char root[ MAX_N ];
+    unsigned j;
+    set_tree( adrs, idx_tree );
+    xmss_sign( key, sig, msg, idx_leaf, adrs );
+    xmss_pk_from_sig( key, root, idx_leaf, sig, msg, adrs );
+    for (j=1; j<key->d; j++) {
+        idx_leaf = idx_tree & ((1ULL << key->hp) - 1);
+        idx_tree = key->hp < 64 ? idx_tree >> key->hp : 0;
+        sig += xmss_sig_bytes( key );
+        set_layer( adrs, j );
+        set_tree( adrs, idx_tree );
+        xmss_sign( key, sig, root, idx_leaf, adrs );
+        if (j < key->d - 1) {
+            xmss_pk_from_sig( key, root, idx_leaf, sig, root, adrs );
+        }
+    }
+}
+
+static int ht_verify( struct slh_key *key, const unsigned char *msg,
+                      const unsigned char *sig, uint64_t idx_tree,
+                      uint32_t idx_leaf ) {
+    adrs_t adrs = { 0 };
+    unsigned char node[ MAX_N ];
+    unsigned j;
+    set_tree( adrs, idx_tree );
+    xmss_pk_from_sig( key, node, idx_leaf, sig, msg, adrs );
+    for (j=1; j<key->d; j++) {
+        idx_leaf = idx_tree & ((1ULL << key->hp) - 1);
+        idx_tree = key->hp < 64 ? idx_tree >> key->hp : 0;
+        sig += xmss_sig_bytes( key );
+        set_layer( adrs, j );
+        set_tree( adrs, idx_tree );
+        xmss_pk_from_sig( key, node, idx_leaf, sig, node, adrs );
+    }
+    return 0 == memcmp( node, key->pk_root, key->n );
+}
+
+/*
+ * FORS
+ */
+static void fors_sk( struct slh_key *key, unsigned char *out,
+                     const adrs_t adrs, uint32_t idx ) {
+    adrs_t sk_adrs;
+    memcpy( sk_adrs, adrs, 32 );
+    set_type( sk_adrs, ADRS_FORS_PRF );
+    set_keypair( sk_adrs, get_keypair( adrs ) );
+    set_tree_index( sk_adrs, idx );
+    thash( key, OP_PRF, out, sk_adrs, key->sk_seed, 1 );
+}
+
+static void fors_node( struct slh_key *key, unsigned char *out, uint32_t i,
+                       unsigned z, adrs_t adrs ) {
+    if (z == 0) {
+        unsigned char sk[ MAX_N ];
+        fors_sk( key, sk, adrs, i );
+        set_tree_height( adrs, 0 );
+        set_tree_index( adrs, i );
+        thash( key, OP_F, out, adrs, sk, 1 );
+        return;
+    }
+    unsigned char nodes[ 2*MAX_N ];
+    fors_node( key, nodes, 2*i, z-1, adrs );
+    fors_node( key, nodes + key->n, 2*i+1, z-1, adrs );
+    set_tree_height( adrs, z );
+    set_tree_index( adrs, i );
+    thash( key, OP_H, out, adrs, nodes, 2 );
+}
+
+/* Each tree's part of the signature is the private value and the auth path */
+static void fors_sign( struct slh_key *key, unsigned char *sig,
+                       const unsigned char *md, adrs_t adrs ) {
+    unsigned *idx = malloc( key->k * sizeof *idx );
+    unsigned i, j, n = key->n, a = key->a;
+    if (!idx) abort();
+    base_2b( idx, md, a, key->k );
+    for (i=0; i<key->k; i++) {
+        uint32_t base = i << a;
+        fors_sk( key, sig, adrs, base + idx[i] );
+        sig += n;
+        for (j=0; j<a; j++) {
+            fors_node( key, sig, (base >> j) + ((idx[i] >> j) ^ 1), j, adrs );
+            sig += n;
+        }
+    }
+    free( idx );
+}
+
+static void fors_pk_from_sig( struct slh_key *key, unsigned char *out,
+                              const unsigned char *sig,
+                              const unsigned char *md, adrs_t adrs ) {
+    unsigned *idx = malloc( key->k * sizeof *idx );
+    unsigned i, j, n = key->n, a = key->a;
+    unsigned char *roots = malloc( key->k * n );
+    unsigned char nodes[ 2*MAX_N ];
+    if (!idx || !roots) abort();
+    base_2b( idx, md, a, key->k );
+    for (i=0; i<key->k; i++) {
+        uint32_t index = (i << a) + idx[i];
+        unsigned char *node = roots + i*n;
+        set_tree_height( adrs, 0 );
+        set_tree_index( adrs, index );
+        thash( key, OP_F, node, adrs, sig, 1 );
+        sig += n;
+        for (j=0; j<a; j++) {
+            set_tree_height( adrs, j+1 );
+            if (((idx[i] >> j) & 1) == 0) {
+                index = index / 2;
+                memcpy( nodes, node, n );
+                memcpy( nodes + n, sig, n );
+            } else {
+                index = (index - 1) / 2;
+                memcpy( nodes, sig, n );
+                memcpy( nodes + n, node, n );
+            }
+            set_tree_index( adrs, index );
+            thash( key, OP_H, node, adrs, nodes, 2 );
+            sig += n;
+        }
+    }
+    adrs_t pk_adrs;
+    memcpy( pk_adrs, adrs, 32 );
+    set_type( pk_adrs, ADRS_FORS_ROOTS );
+    set_keypair( pk_adrs, get_keypair( adrs ) );
+    thash( key, OP_T, out, pk_adrs, roots, key->k );
+    free( roots );
+    free( idx );
+}
+
+/*
+ * Split the message digest into the FORS indices, and which hypertree leaf
+ * to use
+ */
+static void split_digest( const struct slh_key *key, const unsigned char *digest,
+                          uint64_t *idx_tree, uint32_t *idx_leaf ) {
+    unsigned md_len = (key->k * key->a + 7) / 8;
+    unsigned tree_bits = key->h - key->hp;
+    unsigned tree_len = (tree_bits + 7) / 8;
+    unsigned leaf_len = (key->hp + 7) / 8;
+    *idx_tree = to_int( digest + md_len, tree_len );
+    if (tree_bits < 64) *idx_tree &= (1ULL << tree_bits) - 1;
+    *idx_leaf = to_int( digest + md_len + tree_len, leaf_len ) &
+                                                ((1ULL << key->hp) - 1);
+}
+
+/*
+ * The public interface
+ */
+
+/*
+ * Generate a key for the given parameter set (from a fixed seed, so it's
+ * repeatable).  hash is HASH_SHA2 or HASH_SHAKE.  Returns NULL if this
+ * implementation can't do that parameter set
+ */
+struct slh_key *slh_keygen( int hash, unsigned n, unsigned h, unsigned d,
+                            unsigned a, unsigned k, unsigned w ) {
+    unsigned lg_w;
+    for (lg_w = 0; (1u << lg_w) < w; lg_w++) ;
+    if (n > MAX_N || d == 0 || h % d != 0 || (1u << lg_w) != w ||
+            lg_w == 0 || lg_w > 8 || h / d > 30 || h - h/d > 64 ||
+            a == 0 || a > 30 || k == 0 || ((uint64_t)k << a) > UINT32_MAX ||
+            (k*a + 7)/8 + 8 + 4 > MAX_DIGEST ||
+            (hash != HASH_SHA2 && hash != HASH_SHAKE)) {
+        return 0;
+    }
+    struct slh_key *key = calloc( 1, sizeof *key );
+    if (!key) return 0;
+    key->hash = hash;
+    key->n = n; key->h = h; key->d = d; key->hp = h / d;
+    key->a = a; key->k = k; key->w = w; key->lg_w = lg_w;
+
+    key->len1 = (8*n + lg_w - 1) / lg_w;
+    unsigned max_sum = key->len1 * (w-1), prod;
+    for (key->len2 = 1, prod = w; prod <= max_sum; key->len2++, prod *= w) ;
+    key->len = key->len1 + key->len2;
+    key->m = (k*a + 7)/8 + (h - h/d + 7)/8 + (h/d + 7)/8;
+
+    unsigned max_in = key->len > k ? key->len : k;
+    key->buf = malloc( 2*MAX_N + 32 + max_in * n );
+    if (!key->buf) {
+        free( key );
+        return 0;
+    }
+
+    unsigned i;
+    for (i=0; i<n; i++) {
+        key->sk_seed[i] = i;
+        key->sk_prf[i] = 0x40 + i;
+        key->pk_seed[i] = 0x80 + i;
+    }
+
+    /* The state after the (padded) PK.seed block */
+    unsigned char block[128] = { 0 };
+    memcpy( block, key->pk_seed, n );
+    sha256_init( key->seed_state256 );
+    sha256_compress( key->seed_state256, block );
+    sha512_init( key->seed_state512 );
+    sha512_compress( key->seed_state512, block );
+
+    /* And the root of the top Merkle tree */
+    adrs_t adrs = { 0 };
+    set_layer( adrs, d - 1 );
+    xmss_node( key, key->pk_root, 0, key->hp, adrs );
+    return key;
+}
+
+void slh_free( struct slh_key *key ) {
+    if (!key) return;
+    free( key->buf );
+    free( key );
+}
+
+size_t slh_sig_bytes( const struct slh_key *key ) {
+    return key->n * (1 + key->k * (key->a + 1)) + key->d * xmss_sig_bytes( key );
+}
+
+void slh_sign( struct slh_key *key, unsigned char *sig,
+               const unsigned char *msg, size_t len ) {
+    unsigned char digest[ MAX_DIGEST ];
+    uint64_t idx_tree;
+    uint32_t idx_leaf;
+    unsigned char pk_fors[ MAX_N ];
+
+    prf_msg( key, sig, msg, len );          /* R */
+    h_msg( key, digest, sig, msg, len );
+    split_digest( key, digest, &idx_tree, &idx_leaf );
+
+    adrs_t adrs = { 0 };
+    set_tree( adrs, idx_tree );
+    set_type( adrs, ADRS_FORS_TREE );
+    set_keypair( adrs, idx_leaf );
+    unsigned char *sig_fors = sig + key->n;
+    fors_sign( key, sig_fors, digest, adrs );
+    fors_pk_from_sig( key, pk_fors, sig_fors, digest, adrs );
+
+    ht_sign( key, sig_fors + key->k * (key->a + 1) * key->n, pk_fors,
+             idx_tree, idx_leaf );
+}
+
+int slh_verify( struct slh_key *key, const unsigned char *sig,
+                const unsigned char *msg, size_t len ) {
+    unsigned char digest[ MAX_DIGEST ];
+    uint64_t idx_tree;
+    uint32_t idx_leaf;
+    unsigned char pk_fors[ MAX_N ];
+
+    h_msg( key, digest, sig, msg, len );
+    split_digest( key, digest, &idx_tree, &idx_leaf );
+
+    adrs_t adrs = { 0 };
+    set_tree( adrs, idx_tree );
+    set_type( adrs, ADRS_FORS_TREE );
+    set_keypair( adrs, idx_leaf );
+    const unsigned char *sig_fors = sig + key->n;
+    fors_pk_from_sig( key, pk_fors, sig_fors, digest, adrs );
+
+    return ht_verify( key, pk_fors, sig_fors + key->k * (key->a + 1) * key->n,
+                      idx_tree, idx_leaf );
+}
@@ -0,0 +1,12 @@
+#include <stddef.h>
+
+struct slh_key;
+
+struct slh_key *slh_keygen( int hash, unsigned n, unsigned h, unsigned d,
+                            unsigned a, unsigned k, unsigned w );
+void slh_free( struct slh_key *key );
+size_t slh_sig_bytes( const struct slh_key *key );
+void slh_sign( struct slh_key *key, unsigned char *sig,
+               const unsigned char *msg, size_t len );
+int slh_verify( struct slh_key *key, const unsigned char *sig,
+                const unsigned char *msg, size_t len );
@@ -0,0 +1,48 @@
+#!/bin/sh
+#
+# This is a regression test for the cache= cost model: a signer that
+# caches the top layers of the hypertree should never do worse than one
+# that doesn't.  For every parameter set we list, the amortized sign cost
+# must be no more than the serial one, and so budget=cached must find a
+# set at least as small as budget=serial does with the same sign=.  A small
+# number of signatures is where it used to go wrong (caching a layer which
+# we'd expect to rebuild on every signature anyway)
+#
+# It returns nonzero (and says what went wrong) if not
+
+failed=0
+out=${TMPDIR:-/tmp}/test_cached.$$
+for args in "s=128 n=6 sign=100000 h=4" "s=128 n=10 sign=100000 h=5 mixed=1"; do
+    ./search $args cache=4096 format=jsonl > $out.serial 2>/dev/null &&
+    ./search $args cache=4096 budget=cached format=jsonl > $out.cached 2>/dev/null || {
+        echo "FAIL $args: search failed"; failed=1; continue
+    }
+
+    # Each set's amortized cost is no more than its serial cost
+    for f in serial cached; do
+        awk -v args="$args budget=$f" '
+            function field(name) {
+                if (!match( $0, "\"" name "\":[0-9.]+" )) return -1
+                return substr( $0, RSTART + length(name) + 3,
+                               RLENGTH - length(name) - 3 ) + 0
+            }
+            field("sign_cached") > field("sig_time") {
+                print "FAIL " args ": set " field("id") " sign_cached " \
+                      field("sign_cached") " > sig_time " field("sig_time")
+                bad = 1
+            }
+            END { exit bad }' $out.$f || failed=1
+    done
+
+    # And the smallest set within budget is no larger
+    serial=`head -1 $out.serial | sed 's/.*"sig_size":\([0-9]*\).*/\1/'`
+    cached=`head -1 $out.cached | sed 's/.*"sig_size":\([0-9]*\).*/\1/'`
+    if [ -z "$serial" ] || [ -z "$cached" ] || [ "$cached" -gt "$serial" ]; then
+        echo "FAIL $args: budget=cached found $cached bytes," \
+             "budget=serial $serial"
+        failed=1
+    fi
+done
+rm -f $out.serial $out.cached
+[ $failed = 0 ] || exit 1
+echo "cache=: never worse than serial"
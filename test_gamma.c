@@ -0,0 +1,61 @@
+/*
+ * This is the program that lists the potential Sphincs+ parameter sets,
+ * given the target requirements (security level, number of signatures at
+ * that security level, overuse characteristics)
+ *
+ * This is a regression test for check_sec_level (and the batch version),
+ * in each of the kernels this CPU can run.  It checks that they agree with
+ * compute_sec_level just above and just below the actual security level,
+ * at the points where they used to get it wrong:
+ * - When lambda is large, the bound on the rest of the sum left out the
+ *   current a term, and so could declare success early
+ * - Once lambda passed about 709, log2(exp(lambda)) overflowed, and so they
+ *   never saw that the security level was missed
+ * It returns nonzero (and says what went wrong) if any of them disagree
+ */
+#include <stdio.h>
+#include "gamma.h"
+
+#define MARGIN 0.01     /* How far above and below the actual security */
+                        /* level we test */
+
+static const struct point {
+    double m; int H, T, K;
+} point[] = {
+    /* Large lambda, with the terms still growing past g = 2 lambda (the */
+    /* bound on the rest of the sum) */
+    { 34, 30, 4, 28 }, { 34, 30, 4, 46 }, { 35, 30, 5, 73 },
+    { 35, 30, 5, 91 }, { 26, 20, 14, 18 },
+    /* lambda past 709 (log2(exp(lambda)) overflowed) */
+    { 30, 20, 14, 20 }, { 31, 20, 18, 30 }, { 36, 24, 20, 40 },
+    { 42, 30, 22, 35 },
+};
+
+int main(void) {
+    int e, failed = 0;
+    unsigned i;
+    for (e = 0; e < gamma_num_evaluators(); e++) {
+        if (!gamma_evaluator_supported( e )) continue;
+        for (i = 0; i < sizeof point / sizeof *point; i++) {
+            const struct point *p = &point[i];
+            double level = compute_sec_level_reference( p->m, p->H, p->T, p->K );
+            int below = gamma_evaluate_check( e, p->m, p->H, p->T, p->K,
+                                              level - MARGIN );
+            if (below < 0) break;   /* No check version */
+            int above = gamma_evaluate_check( e, p->m, p->H, p->T, p->K,
+                                              level + MARGIN );
+            unsigned char ok[3];
+            gamma_evaluate_check_batch( e, p->m, p->H, p->T, p->K - 1, 3,
+                                        level + MARGIN, ok );
+            if (below != 1 || above != 0 || ok[1] != 0) {
+                printf( "FAIL %s: m=%g H=%d T=%d K=%d (level %.3f): "
+                        "check %d/%d, batch %d\n", gamma_evaluator_name( e ),
+                        p->m, p->H, p->T, p->K, level, below, above, ok[1] );
+                failed++;
+            }
+        }
+    }
+    if (failed) return 1;
+    printf( "check_sec_level: all evaluators agree\n" );
+    return 0;
+}
@@ -0,0 +1,30 @@
+#!/bin/sh
+#
+# This is a regression test for the where= parser of query=: a condition
+# without an operator (where=sig_size) used to take the end of the string
+# as the operator and read past it
+#
+# It returns nonzero (and says what went wrong) if not
+
+failed=0
+out=${TMPDIR:-/tmp}/test_query.$$
+./search s=128 n=6 sign=100000 h=4 dump=$out.dump > /dev/null 2>&1 || {
+    echo "FAIL: dump= failed"; exit 1
+}
+
+# Each of these must be rejected, with a message that names the clause
+for where in "sig_size" "w=16,sig_size" "sig_size,w=16"; do
+    if ./search query=$out.dump where="$where" > /dev/null 2> $out.err; then
+        echo "FAIL where=$where: accepted"; failed=1
+    elif ! grep -q "sig_size" $out.err; then
+        echo "FAIL where=$where: said" `cat $out.err`; failed=1
+    fi
+done
+
+# And a well formed one is still accepted
+./search query=$out.dump where="sig_size<9000,w=16" > /dev/null 2>&1 || {
+    echo "FAIL where=sig_size<9000,w=16: rejected"; failed=1
+}
+rm -f $out.dump $out.dump.idx $out.err
+[ $failed = 0 ] || exit 1
+echo "where=: rejects a condition with no operator"
@@ -0,0 +1,345 @@
+/*
+ * This is the program that lists the potential Sphincs+ parameter sets,
+ * given the target requirements (security level, number of signatures at
+ * that security level, overuse characteristics)
+ *
+ * This part of the program is the differential validation harness: it
+ * evaluates the security level of random (and deliberately awkward)
+ * (m, H, T, K) tuples with each of the evaluators in gamma.c, and compares
+ * them against the high precision reference evaluator.  We want to know that
+ * any faster evaluator gives the same answers before we trust it in the
+ * search
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "validate.h"
+#include "gamma.h"
+
+#define NUM_REGIMES 16      /* floor(log2(lambda)) from -8 (or less) */
+                            /* up to 7 (or more) */
+
+#define COMPUTE_TOLERANCE 1e-4  /* An evaluator 'fails' a sample if its */
+                            /* security level is off by more than this */
+                            /* many bits (and by more than REL_TOLERANCE) */
+#define REL_TOLERANCE     1e-6
+#define CHECK_TOLERANCE   1e-4  /* We don't count a check_sec_level answer */
+                            /* as wrong if the target is within this many */
+                            /* bits of the actual security level */
+
+#define SAMPLES_PER_BATCH 4096  /* How many samples a thread does between */
+                            /* merging its results into the totals */
+#define SOAK_REPORT_SECS  10    /* How often we report in soak mode */
+
+/*
+ * How well one evaluator did within one regime
+ */
+struct regime_stats {
+    unsigned long samples;   /* Number of samples it was valid for */
+    double max_abs;          /* Largest absolute error (in bits) */
+    double max_rel;          /* Largest relative error */
+    unsigned long fails;     /* Samples off by more than the tolerance */
+    unsigned long disagree;  /* check_sec_level gave the wrong answer */
+    unsigned long batch_mismatch; /* check_sec_level_batch didn't match */
+                             /* check_sec_level */
+    double worst_m;          /* The sample with the largest relative error */
+    int worst_H, worst_T, worst_K;
+};
+
+/*
+ * The evaluators are the ones gamma.c knows about, plus 'dispatch', which
+ * is whatever compute_sec_level/check_sec_level pick (which is what the
+ * search actually uses)
+ */
+static int num_eval;
+#define EVAL_DISPATCH (num_eval - 1)
+
+static struct regime_stats *totals;  /* [num_eval][NUM_REGIMES] */
+static unsigned long samples_done;   /* Summed over all threads */
+static unsigned long samples_wanted; /* 0 if we're soaking */
+static pthread_mutex_t totals_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * The random number generator (splitmix64); each thread has its own state
+ */
+static unsigned long long next_random( unsigned long long *state ) {
+    unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/* Uniform in [0, 1) */
+static double uniform( unsigned long long *state ) {
+    return (next_random( state ) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * Pick the next (m, H, T, K) tuple to test.  Half are drawn uniformly over
+ * the space the search (and overuse curves) can ask about; the other half
+ * aim at the places where an evaluator is most likely to go wrong
+ */
+static void pick_sample( unsigned long long *state, double *m, int *H,
+                         int *T, int *K ) {
+    double log_lambda = -40 + 50 * uniform( state );
+    *H = 40 + next_random( state ) % 160;
+    *T = 1 + next_random( state ) % 30;
+    *K = 1 + next_random( state ) % 99;
+
+    switch (next_random( state ) % 8) {
+    case 0: /* Right at the regime boundaries */
+        log_lambda = floor( log_lambda ) +
+                          ((next_random( state ) & 1) ? 1e-9 : -1e-9);
+        break;
+    case 1: /* The smallest and largest FORS trees */
+        *T = (next_random( state ) & 1) ? 1 : 30;
+        break;
+    case 2: /* The fewest and the most FORS trees */
+        *K = (next_random( state ) & 1) ? 1 : 99;
+        break;
+    case 3: /* Drastic overuse, where lambda is large */
+        log_lambda = 6 + 4 * uniform( state );
+        break;
+    case 4: /* Where the first term (about 2^{-TK}) underflows a double */
+        *T = 12 + next_random( state ) % 19;
+        *K = 1 + (1100 + next_random( state ) % 400) / *T;
+        if (*K > 99) *K = 99;
+        break;
+    default: /* Uniformly over the space */
+        break;
+    }
+    *m = *H + log_lambda;
+}
+
+static int regime_of( double m, int H ) {
+    int r = (int)floor( m - H ) + 8;
+    if (r < 0) r = 0;
+    if (r >= NUM_REGIMES) r = NUM_REGIMES-1;
+    return r;
+}
+
+/*
+ * Record the error of a single security level evaluation
+ */
+static void record_error( struct regime_stats *st, double value, double ref,
+                          double m, int H, int T, int K ) {
+    double abs_err = fabs( value - ref );
+    double rel_err = ref != 0 ? abs_err / fabs( ref ) : abs_err;
+    if (isnan( value )) abs_err = rel_err = HUGE_VAL;
+
+    st->samples++;
+    if (abs_err > st->max_abs) st->max_abs = abs_err;
+    if (rel_err > st->max_rel || st->samples == 1) {
+        if (rel_err > st->max_rel) st->max_rel = rel_err;
+        st->worst_m = m; st->worst_H = H; st->worst_T = T; st->worst_K = K;
+    }
+    if (abs_err > COMPUTE_TOLERANCE && rel_err > REL_TOLERANCE) st->fails++;
+}
+
+/*
+ * Record the answer from a check_sec_level evaluation; it's only wrong if
+ * the target isn't too close to the actual security level to tell
+ */
+static void record_check( struct regime_stats *st, int answer, double ref,
+                          double level ) {
+    if (fabs( ref - level ) <= CHECK_TOLERANCE) return;
+    if (answer != (ref >= level)) st->disagree++;
+}
+
+/*
+ * Test a single tuple against every evaluator
+ */
+static void test_sample( struct regime_stats *local, double m, int H,
+                         int T, int K, double level_offset ) {
+    double ref = compute_sec_level_reference( m, H, T, K );
+    double level = ref + level_offset;
+    int r = regime_of( m, H );
+    int e;
+
+    /* Try check_sec_level_batch on a run of K values that includes this */
+    /* one; the first entry is the one we're testing */
+    int batch_count = K + 4 < 100 ? 4 : 100 - K;
+
+    for (e = 0; e < num_eval; e++) {
+        struct regime_stats *st = &local[ e*NUM_REGIMES + r ];
+        double value;
+        int answer;
+        unsigned char batch[4];
+        int b;
+
+        if (e == EVAL_DISPATCH) {
+            value = compute_sec_level( m, H, T, K );
+            answer = check_sec_level( m, H, T, K, level );
+            check_sec_level_batch( m, H, T, K, batch_count, level, batch );
+        } else {
+            if (!gamma_evaluator_supported( e )) continue;
+            value = gamma_evaluate( e, m, H, T, K );
+            if (isnan( value )) continue;   /* Not valid here; that's */
+                                            /* not an error */
+            answer = gamma_evaluate_check( e, m, H, T, K, level );
+            gamma_evaluate_check_batch( e, m, H, T, K, batch_count,
+                                        level, batch );
+        }
+
+        record_error( st, value, ref, m, H, T, K );
+        if (answer < 0) continue;     /* No check version */
+        record_check( st, answer, ref, level );
+
+        /* The batch version must agree precisely with the single one */
+        for (b = 0; b < batch_count; b++) {
+            int single = (e == EVAL_DISPATCH) ?
+                         check_sec_level( m, H, T, K+b, level ) :
+                         gamma_evaluate_check( e, m, H, T, K+b, level );
+            if (single != batch[b]) {
+                st->batch_mismatch++;
+                break;
+            }
+        }
+    }
+}
+
+/*
+ * Add one set of statistics to another
+ */
+static void merge_stats( struct regime_stats *to,
+                         const struct regime_stats *from ) {
+    if (from->max_rel > to->max_rel || (to->samples == 0 && from->samples)) {
+        to->worst_m = from->worst_m; to->worst_H = from->worst_H;
+        to->worst_T = from->worst_T; to->worst_K = from->worst_K;
+    }
+    to->samples += from->samples;
+    if (from->max_abs > to->max_abs) to->max_abs = from->max_abs;
+    if (from->max_rel > to->max_rel) to->max_rel = from->max_rel;
+    to->fails += from->fails;
+    to->disagree += from->disagree;
+    to->batch_mismatch += from->batch_mismatch;
+}
+
+/*
+ * The worker threads
+ */
+static void *worker( void *arg ) {
+    unsigned long long state = (unsigned long long)(size_t)arg * 0x100000001b3ULL;
+    size_t size = num_eval * NUM_REGIMES * sizeof (struct regime_stats);
+    struct regime_stats *local = malloc( size );
+    if (!local) return 0;
+
+    for (;;) {
+        int i;
+        memset( local, 0, size );
+        for (i = 0; i < SAMPLES_PER_BATCH; i++) {
+            double m;
+            int H, T, K;
+            pick_sample( &state, &m, &H, &T, &K );
+
+            /* Test check_sec_level against levels right next to the */
+            /* actual one as well as ones that are further away */
+            double level_offset = (next_random( &state ) & 1) ?
+                          2 * CHECK_TOLERANCE * ((i & 2) ? 1 : -1) :
+                          -4 + 8 * uniform( &state );
+            test_sample( local, m, H, T, K, level_offset );
+        }
+
+        pthread_mutex_lock( &totals_lock );
+        for (i = 0; i < num_eval * NUM_REGIMES; i++) {
+            merge_stats( &totals[i], &local[i] );
+        }
+        samples_done += SAMPLES_PER_BATCH;
+        int done = samples_wanted && samples_done >= samples_wanted;
+        pthread_mutex_unlock( &totals_lock );
+        if (done) break;
+    }
+
+    free( local );
+    return 0;
+}
+
+/*
+ * Print out what we've found so far.  Returns the number of failures
+ * (errors over tolerance, wrong check answers, batch mismatches)
+ */
+static unsigned long report( void ) {
+    unsigned long total_fails = 0;
+    int e, r;
+
+    pthread_mutex_lock( &totals_lock );
+    printf( "Validated %lu samples against the reference evaluator\n",
+            samples_done );
+    for (e = 0; e < num_eval; e++) {
+        if (e != EVAL_DISPATCH && !gamma_evaluator_supported( e )) continue;
+        printf( "\nEvaluator %s:\n",
+                e == EVAL_DISPATCH ? "dispatch" : gamma_evaluator_name( e ) );
+        printf( "  log2(lambda)   samples  max abs err  max rel err     fails  disagree  batch  worst (m, H, T, K)\n" );
+        for (r = 0; r < NUM_REGIMES; r++) {
+            struct regime_stats *st = &totals[ e*NUM_REGIMES + r ];
+            if (!st->samples) continue;
+            printf( "  %s%3d  %10lu  %11.3g  %11.3g  %8lu  %8lu  %5lu  (%.3f, %d, %d, %d)\n",
+                    r == 0 ? "<=" : r == NUM_REGIMES-1 ? ">=" : "  ",
+                    r - 8, st->samples, st->max_abs, st->max_rel,
+                    st->fails, st->disagree, st->batch_mismatch,
+                    st->worst_m, st->worst_H, st->worst_T, st->worst_K );
+            total_fails += st->fails + st->disagree + st->batch_mismatch;
+        }
+    }
+    printf( "\n%s: %lu failures\n", total_fails ? "FAIL" : "PASS", total_fails );
+    fflush( stdout );
+    pthread_mutex_unlock( &totals_lock );
+
+    return total_fails;
+}
+
+/*
+ * Run the validation harness
+ * num_samples - How many samples to test (rounded up to a multiple of the
+ *               batch size).  0 means soak: run until we're killed, and
+ *               report every SOAK_REPORT_SECS seconds
+ * num_threads - How many threads to run; 0 means one per CPU
+ * Returns the number of failures found
+ */
+unsigned long run_validation( unsigned long num_samples, int num_threads ) {
+    int i;
+
+    if (num_threads <= 0) {
+        long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+        num_threads = cpus > 0 ? cpus : 1;
+    }
+
+    num_eval = gamma_num_evaluators() + 1;
+    totals = calloc( num_eval * NUM_REGIMES, sizeof *totals );
+    pthread_t *threads = malloc( num_threads * sizeof *threads );
+    if (!totals || !threads) {
+        fprintf( stderr, "Get a real computer you cheapskate\n" );
+        return 1;
+    }
+    samples_wanted = num_samples;
+    (void)gamma_isa_name();  /* Make sure the kernel is picked before we */
+                             /* start the threads */
+
+    for (i = 0; i < num_threads; i++) {
+        if (0 != pthread_create( &threads[i], 0, worker, (void *)(size_t)(i+1) )) {
+            fprintf( stderr, "Unable to start thread\n" );
+            num_threads = i;
+            break;
+        }
+    }
+
+    if (!num_samples) {
+        for (;;) {
+            sleep( SOAK_REPORT_SECS );
+            report();
+        }
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        pthread_join( threads[i], 0 );
+    }
+    free( threads );
+
+    unsigned long fails = report();
+    free( totals );
+    return fails;
+}
@@ -0,0 +1 @@
+unsigned long run_validation( unsigned long num_samples, int num_threads );
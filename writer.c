@@ -0,0 +1,130 @@
+/*
+ * This is the program that lists the potential Sphincs+ parameter sets,
+ * given the target requirements (security level, number of signatures at
+ * that security level, overuse characteristics)
+ *
+ * This part of the program is a buffered writer, for the machine readable
+ * outputs.  Those can run to millions of rows, and so rather than doing a
+ * printf (and parsing a format string) per field, we convert the numbers
+ * ourselves directly into a large buffer, and write it out when it fills
+ */
+#include <string.h>
+#include "writer.h"
+
+void writer_init( struct writer *w, FILE *f ) {
+    w->f = f;
+    w->len = 0;
+    w->error = 0;
+}
+
+/*
+ * Write out whatever we have buffered; returns 0 if any write (now or
+ * earlier) failed
+ */
+int writer_flush( struct writer *w ) {
+    if (w->len && fwrite( w->buf, 1, w->len, w->f ) != w->len) {
+        w->error = 1;
+    }
+    w->len = 0;
+    if (fflush( w->f ) != 0) w->error = 1;
+    return !w->error;
+}
+
+/*
+ * Make sure that there's room for len more bytes in the buffer
+ */
+static void reserve( struct writer *w, size_t len ) {
+    if (w->len + len > WRITER_BUFFER_SIZE) {
+        if (w->len && fwrite( w->buf, 1, w->len, w->f ) != w->len) {
+            w->error = 1;
+        }
+        w->len = 0;
+    }
+}
+
+void write_bytes( struct writer *w, const void *data, size_t len ) {
+    if (len > WRITER_BUFFER_SIZE) {
+        /* Too big to buffer; write it out directly */
+        reserve( w, WRITER_BUFFER_SIZE );
+        if (fwrite( data, 1, len, w->f ) != len) w->error = 1;
+        return;
+    }
+    reserve( w, len );
+    memcpy( &w->buf[ w->len ], data, len );
+    w->len += len;
+}
+
+void write_str( struct writer *w, const char *s ) {
+    write_bytes( w, s, strlen( s ));
+}
+
+/*
+ * Write the string as a JSON string (that is, quoted, and with anything
+ * JSON doesn't like escaped)
+ */
+void write_json_str( struct writer *w, const char *s ) {
+    static const char hex[] = "0123456789abcdef";
+    reserve( w, 1 );
+    w->buf[ w->len++ ] = '"';
+    for (; *s; s++) {
+        unsigned char c = *s;
+        reserve( w, 6 );
+        if (c == '"' || c == '\\') {
+            w->buf[ w->len++ ] = '\\';
+            w->buf[ w->len++ ] = c;
+        } else if (c < 0x20) {
+            memcpy( &w->buf[ w->len ], "\\u00", 4 );
+            w->buf[ w->len+4 ] = hex[ c >> 4 ];
+            w->buf[ w->len+5 ] = hex[ c & 0xf ];
+            w->len += 6;
+        } else {
+            w->buf[ w->len++ ] = c;
+        }
+    }
+    reserve( w, 1 );
+    w->buf[ w->len++ ] = '"';
+}
+
+void write_uint( struct writer *w, unsigned long long n ) {
+    char digits[20];
+    int z = sizeof digits;
+    do {
+        digits[--z] = (n%10) + '0'; n /= 10;
+    } while (n);
+    write_bytes( w, &digits[z], sizeof digits - z );
+}
+
+void write_int( struct writer *w, long long n ) {
+    if (n < 0) {
+        write_bytes( w, "-", 1 );
+        write_uint( w, -(unsigned long long)n );
+    } else {
+        write_uint( w, n );
+    }
+}
+
+/*
+ * Write n / 10^decimals, with precisely that many digits after the decimal
+ * point; for example, write_fixed( w, 2169, 2 ) writes 21.69
+ */
+void write_fixed( struct writer *w, long long n, int decimals ) {
+    unsigned long long scale = 1;
+    int i;
+    for (i=0; i<decimals; i++) scale *= 10;
+
+    unsigned long long v = n;
+    if (n < 0) {
+        write_bytes( w, "-", 1 );
+        v = -(unsigned long long)n;
+    }
+    write_uint( w, v / scale );
+    if (decimals == 0) return;
+
+    char digits[20];
+    unsigned long long frac = v % scale;
+    for (i = decimals-1; i >= 0; i--) {
+        digits[i] = (frac%10) + '0'; frac /= 10;
+    }
+    write_bytes( w, ".", 1 );
+    write_bytes( w, digits, decimals );
+}
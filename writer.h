@@ -0,0 +1,23 @@
+#include <stdio.h>
+
+#define WRITER_BUFFER_SIZE 65536
+
+/*
+ * A buffered output stream; we format everything into buf ourselves, and
+ * only hand it to stdio when it fills up
+ */
+struct writer {
+    FILE *f;
+    size_t len;               /* Number of bytes in buf */
+    int error;                /* Set if a write failed */
+    char buf[ WRITER_BUFFER_SIZE ];
+};
+
+void writer_init( struct writer *w, FILE *f );
+int writer_flush( struct writer *w );
+void write_bytes( struct writer *w, const void *data, size_t len );
+void write_str( struct writer *w, const char *s );
+void write_json_str( struct writer *w, const char *s );
+void write_uint( struct writer *w, unsigned long long n );
+void write_int( struct writer *w, long long n );
+void write_fixed( struct writer *w, long long n, int decimals );